@@ -0,0 +1,140 @@
+"""
+Grid search algorithms, usable without the Flask server.
+
+Every entry of ALGORITHMS is called as fn(grid, start, end, trace=None) and
+returns (visited_order, path) as lists of [row, col]; `grid` only has to
+support grid[r][c] indexing.
+
+For offline use, solve() takes a numpy array or any other C-contiguous buffer
+of 0/1 bytes directly (see utils.grid_utils.as_grid). The cells are read in
+place, not converted to nested lists. It returns the visited order and path as
+flat int32 arrays, which SearchResult.numpy() exposes as 2D numpy arrays
+without copying them:
+
+    from algorithms import solve
+    result = solve(occupancy, (0, 0), (999, 999), "astar")   # occupancy: uint8 array
+    visited, path = result.numpy()
+"""
+
+from array import array
+from functools import partial
+
+from algorithms.bfs import bfs
+from algorithms.dfs import dfs
+from algorithms.dijkstra import dijkstra
+from algorithms.astar import astar
+from algorithms import kernels
+from algorithms.bidirectional import bidirectional_search
+from algorithms.greedy_best_first import greedy_best_first
+from algorithms.jump_point_search import jump_point_search
+from algorithms.recursive_best_first import recursive_best_first, check_size as rbfs_check_size
+from algorithms.visibility_graph import visibility_graph_search
+from algorithms.block_astar import block_astar
+from utils.grid_utils import as_grid
+
+# Mapping of algorithm keys to functions. Dijkstra and A* (except canonical
+# ordering) run as specialized kernels with the generic functions' output.
+ALGORITHMS = {
+    "bfs": bfs,
+    "dfs": dfs,
+    "dijkstra": kernels.dijkstra,
+    "astar": kernels.astar,
+    "bidirectional": bidirectional_search,
+    "gbfs": greedy_best_first,
+    "jps": jump_point_search,
+    "rbfs": recursive_best_first,
+    "visibility": visibility_graph_search,
+    "block_astar": block_astar,
+    "dijkstra_8": partial(kernels.dijkstra, diagonal=True),
+    "canonical_dijkstra": partial(dijkstra, diagonal=True, canonical=True),
+    "astar_8": partial(kernels.astar, diagonal=True),
+    "canonical_astar": partial(astar, diagonal=True, canonical=True),
+}
+
+# algorithm key -> check(rows, cols) raising ValueError for grids it refuses
+SIZE_LIMITS = {
+    "rbfs": rbfs_check_size,
+}
+
+
+# algorithm key -> {keyword: (min, max)} integer options callers may set
+OPTIONS = {
+    # Larger blocks expand faster once their patterns are in the LDDB, but each
+    # new 8x8 pattern costs 64 in-block searches to solve
+    "block_astar": {"block_size": (2, 8)},
+}
+
+
+def check_grid_size(algorithm, grid):
+    """ Raise ValueError if ALGORITHMS[algorithm] refuses a grid of this size. """
+
+    check = SIZE_LIMITS.get(algorithm)
+    if check is not None:
+        check(len(grid), len(grid[0]) if grid else 0)
+
+
+def check_options(algorithm, options):
+    """ Raise ValueError unless `options` are OPTIONS of ALGORITHMS[algorithm] within range. """
+
+    allowed = OPTIONS.get(algorithm, {})
+    for name, value in options.items():
+        if name not in allowed:
+            raise ValueError(f"'{algorithm}' takes no option '{name}'. Supported: {sorted(allowed)}.")
+        lo, hi = allowed[name]
+        if type(value) is not int or not lo <= value <= hi:
+            raise ValueError(f"{name} must be an integer from {lo} to {hi}.")
+
+
+def _flat_array(entries):
+    flat = array("i")
+    for entry in entries:
+        flat.extend(entry)
+    return flat
+
+
+class SearchResult:
+    """
+    Output of solve(): `visited` and `path` as flat int32 arrays. Path entries
+    are (row, col); visited entries are `visited_width` ints each, (row, col)
+    or block_astar's (row, col, height, width) blocks.
+    """
+
+    def __init__(self, visited, path):
+        self.visited_width = len(visited[0]) if visited else 2
+        self.visited = _flat_array(visited)
+        self.path = _flat_array(path)
+
+    @property
+    def found(self):
+        return len(self.path) > 0
+
+    def numpy(self):
+        """ (visited, path) as (n, width) numpy int32 arrays sharing memory with this result. """
+
+        import numpy
+        return (numpy.frombuffer(self.visited, dtype=numpy.int32).reshape(-1, self.visited_width),
+                numpy.frombuffer(self.path, dtype=numpy.int32).reshape(-1, 2))
+
+
+def solve(cells, start, end, algorithm="astar", shape=None, trace=None, **options):
+    """
+    Run one ALGORITHMS entry on `cells` (a 2D list, or a buffer as accepted by
+    as_grid) and return a SearchResult; `options` are passed through to it (see
+    OPTIONS, e.g. block_size=8 for block_astar). Raises ValueError for an
+    unknown algorithm or option, a bad buffer, a grid the algorithm refuses,
+    or endpoints outside the grid.
+    """
+
+    fn = ALGORITHMS.get(algorithm)
+    if fn is None:
+        raise ValueError(f"Unknown algorithm '{algorithm}'. Supported: {sorted(ALGORITHMS)}.")
+    grid = as_grid(cells, shape)
+    rows, cols = len(grid), len(grid[0]) if grid else 0
+    for name, (r, c) in (("start", start), ("end", end)):
+        if not (0 <= r < rows and 0 <= c < cols):
+            raise ValueError(f"{name} ({r}, {c}) is outside the {rows}x{cols} grid.")
+    check_grid_size(algorithm, grid)
+    check_options(algorithm, options)
+
+    visited, path = fn(grid, (start[0], start[1]), (end[0], end[1]), trace=trace, **options)
+    return SearchResult(visited, path or [])
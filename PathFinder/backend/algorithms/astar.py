@@ -2,30 +2,44 @@
 A* (A-Star) algorithm implementation for the pathfinding visualizer.
 
 Functions:
-    astar(grid, start, end):
+    astar(grid, start, end, diagonal=False, canonical=False, weight=1, trace=None):
         - grid: 2D list of ints where 0 = empty cell, 1 = wall
         - start: tuple (row, col) for the starting cell
         - end: tuple (row, col) for the ending cell
+        - diagonal: allow 8-connected moves (octile costs, no corner cutting)
+        - canonical: with diagonal, generate only canonically ordered successors
+        - weight: heuristic weight; above 1 (weighted A*) expands fewer nodes but the
+                  path may be up to `weight` times longer than the shortest
+        - trace: optional SearchTrace choosing what visited_order records (default: every expansion)
         Returns a tuple (visited_order, path):
             visited_order: list of [row, col] in the order nodes are dequeued (first visit)
             path: list of [row, col] forming the shortest path from start to end (inclusive),
                   or empty list if no path exists
 
-Uses Manhattan distance as the heuristic.
+Uses Manhattan distance as the heuristic (octile distance when diagonal moves are enabled).
 """
 import heapq
 
+from algorithms.canonical import move_cost, octile_heuristic, successor_moves
+from utils.timeline import span
+from utils.trace import SearchTrace
 
-def astar(grid, start, end):
+
+def astar(grid, start, end, diagonal=False, canonical=False, weight=1, trace=None):
     rows = len(grid)
     cols = len(grid[0]) if rows > 0 else 0
 
     def in_bounds(r, c):
         return 0 <= r < rows and 0 <= c < cols
 
+    def passable(r, c):
+        return in_bounds(r, c) and grid[r][c] == 0
+
     def heuristic(a, b):
+        if diagonal:
+            return weight * octile_heuristic(a, b)
         # Manhattan distance
-        return abs(a[0] - b[0]) + abs(a[1] - b[1])
+        return weight * (abs(a[0] - b[0]) + abs(a[1] - b[1]))
 
     # Validate start/end
     if not in_bounds(*start) or not in_bounds(*end):
@@ -44,56 +58,65 @@ def astar(grid, start, end):
     # Priority queue: (f_score, count, node)
     open_heap = []
     heapq.heappush(open_heap, (f_score[start], 0, start))
-    open_set = {start}
 
     parent = {}
     visited = set()
-    visited_order = []
+    if trace is None:
+        trace = SearchTrace()
+    trace.watch(open_heap, node_of=lambda item: list(item[-1]))
+    visit = trace.visitor()
+    push = trace.pusher()
     count = 0
 
     # Neighbor directions: up, right, down, left
     directions = [(-1, 0), (0, 1), (1, 0), (0, -1)]
 
     while open_heap:
-        _, _, current = heapq.heappop(open_heap)
-        open_set.discard(current)
+        f, _, current = heapq.heappop(open_heap)
 
         # Skip if already visited
         if current in visited:
             continue
 
         visited.add(current)
-        visited_order.append([current[0], current[1]])
+        if visit is not None:
+            visit(current, g_score[current], f)
 
         # Check if reached end
         if current == end:
             break
 
         # Explore neighbors
-        for dr, dc in directions:
+        if diagonal:
+            moves = successor_moves(passable, current, parent.get(current), canonical)
+        else:
+            moves = directions
+        for dr, dc in moves:
             nr, nc = current[0] + dr, current[1] + dc
             neighbor = (nr, nc)
             if in_bounds(nr, nc) and neighbor not in visited and grid[nr][nc] == 0:
-                tentative_g = g_score[current] + 1
+                tentative_g = g_score[current] + (move_cost(dr, dc) if diagonal else 1)
                 if tentative_g < g_score[neighbor]:
                     parent[neighbor] = current
                     g_score[neighbor] = tentative_g
                     f_score[neighbor] = tentative_g + heuristic(neighbor, end)
-                    if neighbor not in open_set:
-                        count += 1
-                        heapq.heappush(open_heap, (f_score[neighbor], count, neighbor))
-                        open_set.add(neighbor)
+                    # Push on every improvement; stale heap entries are skipped once visited
+                    count += 1
+                    heapq.heappush(open_heap, (f_score[neighbor], count, neighbor))
+                    if push is not None:
+                        push(neighbor, tentative_g, f_score[neighbor])
 
     # Reconstruct path
-    path = []
-    if end in parent or start == end:
-        node = end
-        while node != start:
-            path.append([node[0], node[1]])
-            node = parent.get(node)
-            if node is None:
-                break
-        path.append([start[0], start[1]])
-        path.reverse()
-
-    return visited_order, path
+    with span("reconstruction"):
+        path = []
+        if end in parent or start == end:
+            node = end
+            while node != start:
+                path.append([node[0], node[1]])
+                node = parent.get(node)
+                if node is None:
+                    break
+            path.append([start[0], start[1]])
+            path.reverse()
+
+    return trace.visited, path
@@ -2,10 +2,11 @@
 Breadth-First Search (BFS) implementation for the pathfinding visualizer.
 
 Functions:
-    bfs(grid, start, end):
+    bfs(grid, start, end, trace=None):
         - grid: 2D list of ints where 0 = empty cell, 1 = wall
         - start: tuple (row, col) for the starting cell
         - end: tuple (row, col) for the ending cell
+        - trace: optional SearchTrace choosing what visited_order records (default: every expansion)
         Returns a tuple (visited_order, path):
             visited_order: list of [row, col] in the order nodes are visited
             path: list of [row, col] forming the shortest path from start to end (inclusive),
@@ -14,7 +15,10 @@ Functions:
 
 from collections import deque
 
-def bfs(grid, start, end):
+from utils.timeline import span
+from utils.trace import SearchTrace
+
+def bfs(grid, start, end, trace=None):
     # Dimensions
     rows = len(grid)
     cols = len(grid[0]) if rows > 0 else 0
@@ -31,10 +35,14 @@ def bfs(grid, start, end):
 
     visited = set()
     parent = {}
-    visited_order = []
+    if trace is None:
+        trace = SearchTrace()
+    visit = trace.visitor()
+    push = trace.pusher()
 
     # Queue for BFS
     queue = deque()
+    trace.watch(queue)
     queue.append(start)
     visited.add(start)
 
@@ -44,7 +52,8 @@ def bfs(grid, start, end):
     found = False
     while queue:
         current = queue.popleft()
-        visited_order.append([current[0], current[1]])
+        if visit is not None:
+            visit(current)
 
         if current == end:
             found = True
@@ -55,20 +64,23 @@ def bfs(grid, start, end):
             neighbor = (nr, nc)
             if in_bounds(nr, nc) and neighbor not in visited and grid[nr][nc] == 0:
                 queue.append(neighbor)
+                if push is not None:
+                    push(neighbor)
                 visited.add(neighbor)
                 parent[neighbor] = current
 
     # Reconstruct path if end was reached
-    path = []
-    if found:
-        node = end
-        while node != start:
-            path.append([node[0], node[1]])
-            node = parent.get(node)
-            if node is None:
-                break
-        # Add the start at the beginning
-        path.append([start[0], start[1]])
-        path.reverse()
+    with span("reconstruction"):
+        path = []
+        if found:
+            node = end
+            while node != start:
+                path.append([node[0], node[1]])
+                node = parent.get(node)
+                if node is None:
+                    break
+            # Add the start at the beginning
+            path.append([start[0], start[1]])
+            path.reverse()
 
-    return visited_order, path
\ No newline at end of file
+    return trace.visited, path
\ No newline at end of file
@@ -2,10 +2,11 @@
 Bidirectional Search implementation for the pathfinding visualizer.
 
 Functions:
-    bidirectional_search(grid, start, end):
+    bidirectional_search(grid, start, end, trace=None):
         - grid: 2D list of ints where 0 = empty cell, 1 = wall
         - start: tuple (row, col) for the starting cell
         - end: tuple (row, col) for the ending cell
+        - trace: optional SearchTrace choosing what visited_order records (default: every expansion)
         Returns a tuple (visited_order, path):
             visited_order: list of [row, col] in the order nodes are visited from both searches
             path: list of [row, col] forming the shortest path from start to end (inclusive),
@@ -13,7 +14,10 @@ Functions:
 """
 from collections import deque
 
-def bidirectional_search(grid, start, end):
+from utils.timeline import span
+from utils.trace import SearchTrace
+
+def bidirectional_search(grid, start, end, trace=None):
     rows = len(grid)
     cols = len(grid[0]) if rows > 0 else 0
 
@@ -35,7 +39,11 @@ def bidirectional_search(grid, start, end):
     b_visited = {end}
     f_parent = {}
     b_parent = {}
-    visited_order = []
+    if trace is None:
+        trace = SearchTrace()
+    trace.watch(f_queue, b_queue)
+    visit = trace.visitor()
+    push = trace.pusher()
     meet_node = None
 
     # Directions: up, right, down, left
@@ -46,12 +54,15 @@ def bidirectional_search(grid, start, end):
         # Forward step
         for _ in range(len(f_queue)):
             current = f_queue.popleft()
-            visited_order.append([current[0], current[1]])
+            if visit is not None:
+                visit(current)
             for dr, dc in directions:
                 nr, nc = current[0] + dr, current[1] + dc
                 neighbor = (nr, nc)
                 if in_bounds(nr, nc) and neighbor not in f_visited and grid[nr][nc] == 0:
                     f_queue.append(neighbor)
+                    if push is not None:
+                        push(neighbor)
                     f_visited.add(neighbor)
                     f_parent[neighbor] = current
                     if neighbor in b_visited:
@@ -65,12 +76,15 @@ def bidirectional_search(grid, start, end):
         # Backward step
         for _ in range(len(b_queue)):
             current = b_queue.popleft()
-            visited_order.append([current[0], current[1]])
+            if visit is not None:
+                visit(current)
             for dr, dc in directions:
                 nr, nc = current[0] + dr, current[1] + dc
                 neighbor = (nr, nc)
                 if in_bounds(nr, nc) and neighbor not in b_visited and grid[nr][nc] == 0:
                     b_queue.append(neighbor)
+                    if push is not None:
+                        push(neighbor)
                     b_visited.add(neighbor)
                     b_parent[neighbor] = current
                     if neighbor in f_visited:
@@ -81,28 +95,29 @@ def bidirectional_search(grid, start, end):
 
     # No connection found
     if meet_node is None:
-        return visited_order, []
+        return trace.visited, []
 
     # Reconstruct path
-    # Forward path from start to meet_node
-    path_f = []
-    node = meet_node
-    while node != start:
-        path_f.append([node[0], node[1]])
-        node = f_parent.get(node)
-        if node is None:
-            break
-    path_f.append([start[0], start[1]])
-    path_f.reverse()
+    with span("reconstruction"):
+        # Forward path from start to meet_node
+        path_f = []
+        node = meet_node
+        while node != start:
+            path_f.append([node[0], node[1]])
+            node = f_parent.get(node)
+            if node is None:
+                break
+        path_f.append([start[0], start[1]])
+        path_f.reverse()
 
-    # Backward path from meet_node to end (exclude meet_node duplicate)
-    path_b = []
-    node = meet_node
-    while node != end:
-        node = b_parent.get(node)
-        if node is None:
-            break
-        path_b.append([node[0], node[1]])
+        # Backward path from meet_node to end (exclude meet_node duplicate)
+        path_b = []
+        node = meet_node
+        while node != end:
+            node = b_parent.get(node)
+            if node is None:
+                break
+            path_b.append([node[0], node[1]])
 
-    full_path = path_f + path_b
-    return visited_order, full_path
+        full_path = path_f + path_b
+    return trace.visited, full_path
@@ -0,0 +1,265 @@
+"""
+Block A* implementation for the pathfinding visualizer.
+
+Functions:
+    block_astar(grid, start, end, block_size=4, trace=None):
+        - grid: 2D list of ints where 0 = empty cell, 1 = wall
+        - start: tuple (row, col) for the starting cell
+        - end: tuple (row, col) for the ending cell
+        - block_size: side length of the square blocks the grid is cut into
+        - trace: optional SearchTrace choosing what visited_order records (default: every expansion)
+        Returns a tuple (visited_order, path):
+            visited_order: list of [row, col, height, width] blocks in the order they are first expanded
+            path: list of [row, col] forming the shortest path from start to end (inclusive),
+                  or empty list if no path exists
+
+The grid is partitioned into blocks and the search expands a whole block per
+step. Distances inside a block come from a local distance database (LDDB) keyed
+by the block's wall pattern: each occupancy pattern is solved on first use and
+reused across blocks, queries and requests. The LDDB keeps its tables as flat
+byte arrays in an LRU cache of at most LDDB_MAX_BYTES, and charges them to the
+residency budget (utils/residency.py) as the "lddb" artifact of "block_astar".
+"""
+
+import heapq
+import threading
+from array import array
+from collections import OrderedDict
+
+from utils.residency import residency
+from utils.timeline import span
+from utils.trace import SearchTrace
+
+# (block_size, wall pattern) -> flat all-pairs in-block distance table, least recently used first
+_lddb = OrderedDict()
+_lddb_bytes = 0
+_lddb_lock = threading.Lock()
+# Room for all 65,536 4x4 patterns (16 MB), or about 8,000 8x8 ones
+LDDB_MAX_BYTES = 32 << 20
+LDDB_OWNER, LDDB_ARTIFACT = "block_astar", "lddb"
+
+INF = float('inf')
+
+
+def unreachable(size):
+    """ Table entry for a cell that cannot be reached (or is a wall) in blocks of `size`. """
+
+    return 0xFF if size * size < 0xFF else 0xFFFF
+
+
+def _solve_pattern(size, pattern):
+    # Pattern bit i is set when local cell (i // size, i % size) is blocked;
+    # entry src * n + dst is the distance from local cell src to dst
+    n = size * size
+    none = unreachable(size)
+    table = array("B" if none == 0xFF else "H", [none]) * (n * n)
+    for src in range(n):
+        if (pattern >> src) & 1:
+            continue
+        base = src * n
+        table[base + src] = 0
+        frontier = [src]
+        while frontier:
+            nxt = []
+            for i in frontier:
+                r, c = divmod(i, size)
+                for nr, nc in ((r - 1, c), (r, c + 1), (r + 1, c), (r, c - 1)):
+                    j = nr * size + nc
+                    if (0 <= nr < size and 0 <= nc < size and table[base + j] == none
+                            and not (pattern >> j) & 1):
+                        table[base + j] = table[base + i] + 1
+                        nxt.append(j)
+            frontier = nxt
+    return table
+
+
+def _clear_lddb():
+    # Residency eviction callback
+    global _lddb_bytes
+    with _lddb_lock:
+        _lddb.clear()
+        _lddb_bytes = 0
+
+
+def lddb_lookup(size, pattern):
+    """ Return the flat in-block distance table for a wall pattern, solving it on first use. """
+
+    global _lddb_bytes
+    key = (size, pattern)
+    with _lddb_lock:
+        table = _lddb.get(key)
+        if table is not None:
+            _lddb.move_to_end(key)
+            return table
+    table = _solve_pattern(size, pattern)
+    with _lddb_lock:
+        if key in _lddb:
+            return _lddb[key]
+        _lddb[key] = table
+        _lddb_bytes += table.itemsize * len(table)
+        while _lddb_bytes > LDDB_MAX_BYTES and len(_lddb) > 1:
+            _, old = _lddb.popitem(last=False)
+            _lddb_bytes -= old.itemsize * len(old)
+        total = _lddb_bytes
+    residency.charge(LDDB_OWNER, LDDB_ARTIFACT, total, _clear_lddb)
+    return table
+
+
+def block_astar(grid, start, end, block_size=4, trace=None):
+    rows = len(grid)
+    cols = len(grid[0]) if rows > 0 else 0
+    size = block_size
+
+    def in_bounds(r, c):
+        return 0 <= r < rows and 0 <= c < cols
+
+    def heuristic(a, b):
+        # Manhattan distance
+        return abs(a[0] - b[0]) + abs(a[1] - b[1])
+
+    # Validate start/end
+    if not in_bounds(*start) or not in_bounds(*end):
+        return [], []
+    if grid[start[0]][start[1]] == 1 or grid[end[0]][end[1]] == 1:
+        return [], []
+    start, end = tuple(start), tuple(end)
+
+    def block_of(cell):
+        return (cell[0] // size, cell[1] // size)
+
+    # Out-of-grid cells of edge blocks count as walls
+    patterns = {}
+
+    def block_table(block):
+        pattern = patterns.get(block)
+        if pattern is None:
+            r0, c0 = block[0] * size, block[1] * size
+            pattern, bit = 0, 0
+            for r in range(r0, r0 + size):
+                row = grid[r] if r < rows else None
+                for c in range(c0, c0 + size):
+                    if row is None or c >= cols or row[c] == 1:
+                        pattern |= 1 << bit
+                    bit += 1
+            patterns[block] = pattern
+        return lddb_lookup(size, pattern)
+
+    def local(cell):
+        return (cell[0] % size) * size + cell[1] % size
+
+    n = size * size
+    none = unreachable(size)
+    residency.touch(LDDB_OWNER, LDDB_ARTIFACT)
+
+    # Only perimeter cells can leave a block, so expansions relax just those
+    # (plus the end cell in its own block): (local index, row, col, moves out)
+    egress = []
+    for j in range(n):
+        lr, lc = divmod(j, size)
+        moves = [(dr, dc) for dr, dc in ((-1, 0), (0, 1), (1, 0), (0, -1))
+                 if not (0 <= lr + dr < size and 0 <= lc + dc < size)]
+        if moves:
+            egress.append((j, lr, lc, moves))
+    exits = {j: moves for j, _, _, moves in egress}
+    end_block = block_of(end)
+    if local(end) not in exits:
+        end_targets = egress + [(local(end), end[0] % size, end[1] % size, [])]
+    else:
+        end_targets = egress
+
+    g_score = {start: 0}
+    # parent[cell] = (previous cell, True if reached across the previous cell's block)
+    parent = {}
+    # Ingress cells per block whose cost dropped since the block was last expanded
+    dirty = {block_of(start): {start}}
+
+    open_heap = [(heuristic(start, end), 0, block_of(start))]
+    count = 0
+    expanded = set()
+    if trace is None:
+        trace = SearchTrace()
+    trace.watch(dirty, node_of=lambda block: [block[0] * size, block[1] * size, size, size])
+    visit = trace.visitor()
+    push = trace.pusher()
+
+    while open_heap:
+        key, _, block = heapq.heappop(open_heap)
+        sources = dirty.pop(block, None)
+        if not sources:
+            continue
+        if key >= g_score.get(end, INF):
+            break
+
+        if block not in expanded:
+            expanded.add(block)
+            r0, c0 = block[0] * size, block[1] * size
+            if visit is not None:
+                visit([r0, c0, min(size, rows - r0), min(size, cols - c0)], None, key)
+
+        # Relax the block's egress cells from the dirty ingress cells via the LDDB
+        table = block_table(block)
+        r0, c0 = block[0] * size, block[1] * size
+        improved = [(src, exits.get(local(src), ())) for src in sources]
+        for src in sources:
+            k = local(src) * n
+            base = g_score[src]
+            for j, lr, lc, moves in (end_targets if block == end_block else egress):
+                d = table[k + j]
+                if d == none:
+                    continue
+                cell = (r0 + lr, c0 + lc)
+                if base + d < g_score.get(cell, INF):
+                    g_score[cell] = base + d
+                    parent[cell] = (src, True)
+                    improved.append((cell, moves))
+
+        # Push improvements across the block boundary
+        br, bc = block
+        for cell, moves in improved:
+            r, c = cell
+            g = g_score[cell]
+            for dr, dc in moves:
+                nr, nc = r + dr, c + dc
+                if not (0 <= nr < rows and 0 <= nc < cols) or grid[nr][nc] == 1:
+                    continue
+                neighbor = (nr, nc)
+                nblock = (br + dr, bc + dc)
+                tentative_g = g + 1
+                if tentative_g < g_score.get(neighbor, INF):
+                    g_score[neighbor] = tentative_g
+                    parent[neighbor] = (cell, False)
+                    dirty.setdefault(nblock, set()).add(neighbor)
+                    count += 1
+                    f = tentative_g + heuristic(neighbor, end)
+                    heapq.heappush(open_heap, (f, count, nblock))
+                    if push is not None:
+                        push(neighbor, tentative_g, f)
+
+    # Reconstruct path, unrolling in-block legs by descending the LDDB distances
+    with span("reconstruction"):
+        path = []
+        if end in g_score:
+            node = end
+            while node != start:
+                prev, inside = parent[node]
+                if not inside:
+                    path.append([node[0], node[1]])
+                else:
+                    block = block_of(node)
+                    table = block_table(block)
+                    k = local(prev) * n
+                    row = table[k:k + n]
+                    r0, c0 = block[0] * size, block[1] * size
+                    while node != prev:
+                        path.append([node[0], node[1]])
+                        r, c = node
+                        for nr, nc in ((r - 1, c), (r, c + 1), (r + 1, c), (r, c - 1)):
+                            if (block_of((nr, nc)) == block
+                                    and row[local((nr, nc))] == row[local(node)] - 1):
+                                node = (nr, nc)
+                                break
+                node = prev
+            path.append([start[0], start[1]])
+            path.reverse()
+
+    return trace.visited, path
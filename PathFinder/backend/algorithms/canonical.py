@@ -0,0 +1,80 @@
+"""
+8-connected move generation shared by Dijkstra and A*.
+
+Diagonal moves may not cut corners: both orthogonal cells next to the move must
+be open. Costs are kept as integers (straight 100, diagonal 141) so equal-cost
+symmetric paths compare exactly equal regardless of summation order.
+
+Canonical ordering prunes the symmetric paths that 8-connectivity introduces:
+every optimal path has an equal-cost twin that takes its diagonal moves before
+its straight ones, so only successors consistent with that order (plus the
+"forced" ones an adjacent wall makes necessary) are generated. This is the
+per-step pruning rule of Jump Point Search without the jumping.
+"""
+
+STRAIGHT_COST = 100
+DIAGONAL_COST = 141
+
+# Up, right, down, left, then the four diagonals
+CARDINALS = [(-1, 0), (0, 1), (1, 0), (0, -1)]
+DIAGONALS = [(-1, 1), (1, 1), (1, -1), (-1, -1)]
+ALL_MOVES = CARDINALS + DIAGONALS
+
+
+def octile_heuristic(a, b):
+    dr = abs(a[0] - b[0])
+    dc = abs(a[1] - b[1])
+    return STRAIGHT_COST * abs(dr - dc) + DIAGONAL_COST * min(dr, dc)
+
+
+def move_cost(dr, dc):
+    return DIAGONAL_COST if dr and dc else STRAIGHT_COST
+
+
+def _legal(passable, r, c, dr, dc):
+    if not passable(r + dr, c + dc):
+        return False
+    if dr and dc:
+        return passable(r + dr, c) and passable(r, c + dc)
+    return True
+
+
+def octile_moves(passable, r, c):
+    """ All legal (dr, dc) moves out of (r, c). """
+
+    return [(dr, dc) for dr, dc in ALL_MOVES if _legal(passable, r, c, dr, dc)]
+
+
+def canonical_moves(passable, r, c, direction):
+    """
+    Legal (dr, dc) moves out of (r, c) given the move `direction` that reached it
+    (None at the start node, where every move is canonical).
+    """
+
+    if direction is None:
+        return octile_moves(passable, r, c)
+
+    dr, dc = direction
+    if dr and dc:
+        # After a diagonal: keep going diagonally or peel off along either axis
+        candidates = [(dr, 0), (0, dc), (dr, dc)]
+    else:
+        # After a straight move: keep going, unless a wall beside the previous
+        # cell hides a side cell that no shorter path can reach
+        candidates = [(dr, dc)]
+        for side in (-1, 1):
+            sr, sc = (side, 0) if dc else (0, side)
+            if not passable(r + sr - dr, c + sc - dc) and passable(r + sr, c + sc):
+                candidates.append((sr, sc))
+                candidates.append((sr + dr, sc + dc))
+
+    return [(mr, mc) for mr, mc in candidates if _legal(passable, r, c, mr, mc)]
+
+
+def successor_moves(passable, node, came_from, canonical):
+    """ Moves to generate from `node`, pruned canonically when `canonical` is set. """
+
+    if not canonical or came_from is None:
+        return octile_moves(passable, node[0], node[1])
+    direction = (node[0] - came_from[0], node[1] - came_from[1])
+    return canonical_moves(passable, node[0], node[1], direction)
@@ -2,10 +2,11 @@
 Depth-First Search (DFS) implementation for the pathfinding visualizer.
 
 Functions:
-    dfs(grid, start, end):
+    dfs(grid, start, end, trace=None):
         - grid: 2D list of ints where 0 = empty cell, 1 = wall
         - start: tuple (row, col) for the starting cell
         - end: tuple (row, col) for the ending cell
+        - trace: optional SearchTrace choosing what visited_order records (default: every expansion)
         Returns a tuple (visited_order, path):
             visited_order: list of [row, col] in the order nodes are visited
             path: list of [row, col] forming a path from start to end (inclusive),
@@ -13,7 +14,10 @@ Functions:
 Note: DFS does not guarantee shortest path in unweighted graphs, but will return a valid path.
 """
 
-def dfs(grid, start, end):
+from utils.timeline import span
+from utils.trace import SearchTrace
+
+def dfs(grid, start, end, trace=None):
     rows = len(grid)
     cols = len(grid[0]) if rows > 0 else 0
 
@@ -28,10 +32,14 @@ def dfs(grid, start, end):
 
     visited = set()
     parent = {}
-    visited_order = []
+    if trace is None:
+        trace = SearchTrace()
+    visit = trace.visitor()
+    push = trace.pusher()
 
     # Stack for DFS
     stack = [start]
+    trace.watch(stack)
     visited.add(start)
 
     # Directions: up, right, down, left
@@ -40,7 +48,8 @@ def dfs(grid, start, end):
     found = False
     while stack:
         current = stack.pop()
-        visited_order.append([current[0], current[1]])
+        if visit is not None:
+            visit(current)
 
         if current == end:
             found = True
@@ -52,20 +61,23 @@ def dfs(grid, start, end):
             neighbor = (nr, nc)
             if in_bounds(nr, nc) and neighbor not in visited and grid[nr][nc] == 0:
                 stack.append(neighbor)
+                if push is not None:
+                    push(neighbor)
                 visited.add(neighbor)
                 parent[neighbor] = current
 
     # Reconstruct path if found
-    path = []
-    if found:
-        node = end
-        while node != start:
-            path.append([node[0], node[1]])
-            node = parent.get(node)
-            if node is None:
-                break
-        # Add start
-        path.append([start[0], start[1]])
-        path.reverse()
+    with span("reconstruction"):
+        path = []
+        if found:
+            node = end
+            while node != start:
+                path.append([node[0], node[1]])
+                node = parent.get(node)
+                if node is None:
+                    break
+            # Add start
+            path.append([start[0], start[1]])
+            path.reverse()
 
-    return visited_order, path
+    return trace.visited, path
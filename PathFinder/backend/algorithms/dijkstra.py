@@ -2,28 +2,38 @@
 Dijkstra's algorithm implementation for the pathfinding visualizer.
 
 Functions:
-    dijkstra(grid, start, end):
+    dijkstra(grid, start, end, diagonal=False, canonical=False, trace=None):
         - grid: 2D list of ints where 0 = empty cell, 1 = wall
         - start: tuple (row, col) for the starting cell
         - end: tuple (row, col) for the ending cell
+        - diagonal: allow 8-connected moves (octile costs, no corner cutting)
+        - canonical: with diagonal, generate only canonically ordered successors
+        - trace: optional SearchTrace choosing what visited_order records (default: every expansion)
         Returns a tuple (visited_order, path):
             visited_order: list of [row, col] in the order nodes are dequeued (first visit)
             path: list of [row, col] forming the shortest path from start to end (inclusive),
                   or empty list if no path exists
 
-All edges are assumed to have weight 1.
+All edges are assumed to have weight 1 (octile weights when diagonal moves are enabled).
 """
 
 import heapq
 
+from algorithms.canonical import move_cost, successor_moves
+from utils.timeline import span
+from utils.trace import SearchTrace
 
-def dijkstra(grid, start, end):
+
+def dijkstra(grid, start, end, diagonal=False, canonical=False, trace=None):
     rows = len(grid)
     cols = len(grid[0]) if rows > 0 else 0
 
     def in_bounds(r, c):
         return 0 <= r < rows and 0 <= c < cols
 
+    def passable(r, c):
+        return in_bounds(r, c) and grid[r][c] == 0
+
     # Validate start/end
     if not in_bounds(*start) or not in_bounds(*end):
         return [], []
@@ -42,7 +52,11 @@ def dijkstra(grid, start, end):
     heapq.heappush(heap, (0, start))
 
     visited = set()
-    visited_order = []
+    if trace is None:
+        trace = SearchTrace()
+    trace.watch(heap, node_of=lambda item: list(item[-1]))
+    visit = trace.visitor()
+    push = trace.pusher()
 
     # Neighbor directions: up, right, down, left
     directions = [(-1, 0), (0, 1), (1, 0), (0, -1)]
@@ -55,34 +69,42 @@ def dijkstra(grid, start, end):
             continue
 
         visited.add(current)
-        visited_order.append([current[0], current[1]])
+        if visit is not None:
+            visit(current, dist, dist)
 
         # Stop if we reached the end
         if current == end:
             break
 
         # Explore neighbors
-        for dr, dc in directions:
+        if diagonal:
+            moves = successor_moves(passable, current, parent.get(current), canonical)
+        else:
+            moves = directions
+        for dr, dc in moves:
             nr, nc = current[0] + dr, current[1] + dc
             neighbor = (nr, nc)
             if in_bounds(nr, nc) and neighbor not in visited and grid[nr][nc] == 0:
-                new_dist = dist + 1  # all edges weight=1
+                new_dist = dist + (move_cost(dr, dc) if diagonal else 1)
                 if new_dist < distances[neighbor]:
                     distances[neighbor] = new_dist
                     parent[neighbor] = current
                     heapq.heappush(heap, (new_dist, neighbor))
+                    if push is not None:
+                        push(neighbor, new_dist, new_dist)
 
     # Reconstruct shortest path
-    path = []
-    if end in parent or start == end:
-        # Walk from end to start
-        node = end
-        while node != start:
-            path.append([node[0], node[1]])
-            node = parent.get(node)
-            if node is None:
-                break
-        path.append([start[0], start[1]])
-        path.reverse()
-
-    return visited_order, path
+    with span("reconstruction"):
+        path = []
+        if end in parent or start == end:
+            # Walk from end to start
+            node = end
+            while node != start:
+                path.append([node[0], node[1]])
+                node = parent.get(node)
+                if node is None:
+                    break
+            path.append([start[0], start[1]])
+            path.reverse()
+
+    return trace.visited, path
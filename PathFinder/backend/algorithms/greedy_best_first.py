@@ -2,10 +2,11 @@
 Greedy Best-First Search (GBFS) implementation for the pathfinding visualizer.
 
 Functions:
-    greedy_best_first(grid, start, end):
+    greedy_best_first(grid, start, end, trace=None):
         - grid: 2D list of ints where 0 = empty cell, 1 = wall
         - start: tuple (row, col) for the starting cell
         - end: tuple (row, col) for the ending cell
+        - trace: optional SearchTrace choosing what visited_order records (default: every expansion)
         Returns a tuple (visited_order, path):
             visited_order: list of [row, col] in the order nodes are dequeued
             path: list of [row, col] forming the path from start to end (inclusive),
@@ -15,7 +16,10 @@ Uses only the heuristic to guide the search (no accumulated cost).
 
 import heapq
 
-def greedy_best_first(grid, start, end):
+from utils.timeline import span
+from utils.trace import SearchTrace
+
+def greedy_best_first(grid, start, end, trace=None):
     rows = len(grid)
     cols = len(grid[0]) if rows > 0 else 0
 
@@ -39,18 +43,23 @@ def greedy_best_first(grid, start, end):
     heapq.heappush(open_heap, (start_h, count, start))
     visited = set()
     parent = {}
-    visited_order = []
+    if trace is None:
+        trace = SearchTrace()
+    trace.watch(open_heap, node_of=lambda item: list(item[-1]))
+    visit = trace.visitor()
+    push = trace.pusher()
 
     # Neighbor directions: up, right, down, left
     directions = [(-1,0),(0,1),(1,0),(0,-1)]
 
     while open_heap:
-        _, _, current = heapq.heappop(open_heap)
+        h, _, current = heapq.heappop(open_heap)
         if current in visited:
             continue
 
         visited.add(current)
-        visited_order.append([current[0], current[1]])
+        if visit is not None:
+            visit(current, None, h)
 
         if current == end:
             break
@@ -63,17 +72,20 @@ def greedy_best_first(grid, start, end):
                 count += 1
                 h = heuristic(neighbor, end)
                 heapq.heappush(open_heap, (h, count, neighbor))
+                if push is not None:
+                    push(neighbor, None, h)
 
     # Reconstruct path
-    path = []
-    if end in parent or start == end:
-        node = end
-        while node != start:
-            path.append([node[0], node[1]])
-            node = parent.get(node)
-            if node is None:
-                break
-        path.append([start[0], start[1]])
-        path.reverse()
+    with span("reconstruction"):
+        path = []
+        if end in parent or start == end:
+            node = end
+            while node != start:
+                path.append([node[0], node[1]])
+                node = parent.get(node)
+                if node is None:
+                    break
+            path.append([start[0], start[1]])
+            path.reverse()
 
-    return visited_order, path
+    return trace.visited, path
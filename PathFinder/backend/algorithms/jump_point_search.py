@@ -1,6 +1,9 @@
 import heapq
 
-def jump_point_search(grid, start, end):
+from utils.timeline import span
+from utils.trace import SearchTrace
+
+def jump_point_search(grid, start, end, trace=None):
     rows, cols = len(grid), len(grid[0]) if grid else 0
 
     def in_bounds(r, c):
@@ -12,45 +15,84 @@ def jump_point_search(grid, start, end):
     def heuristic(a, b):
         return abs(a[0]-b[0]) + abs(a[1]-b[1])
 
+    # Validate start/end
+    if not in_bounds(*start) or not in_bounds(*end):
+        return [], []
+    if grid[start[0]][start[1]] == 1 or grid[end[0]][end[1]] == 1:
+        return [], []
+    start, end = tuple(start), tuple(end)
+
     DIRS = [(-1,0),(0,1),(1,0),(0,-1)]
 
-    def jump(r, c, dr, dc):
-        nr, nc = r + dr, c + dc
-        if not passable(nr, nc):
-            return None
-        if (nr, nc) == end:
-            return (nr, nc)
+    # Horizontal jumps stop at the end or where a cell above or below opens up
+    # that the previous cell could not step into. Each row's jump results are
+    # worked out in one sweep per direction the first time the row is reached,
+    # so later jumps along or across it are lookups
+    horizontal_jumps = {}
 
-        # forced neighbor checks
-        if dr != 0:
-            if (passable(nr, nc+1) and not passable(r, nc+1)) or \
-               (passable(nr, nc-1) and not passable(r, nc-1)):
-                return (nr, nc)
-        elif dc != 0:
-            if (passable(nr+1, nc) and not passable(nr, c)) or \
-               (passable(nr-1, nc) and not passable(nr, c)):
-                return (nr, nc)
+    def horizontal(r, dc):
+        table = horizontal_jumps.get((r, dc))
+        if table is None:
+            table = [None] * cols
+            row = grid[r]
+            up = grid[r - 1] if r > 0 else None
+            down = grid[r + 1] if r + 1 < rows else None
+            end_c = end[1] if end[0] == r else -1
+            for c in (range(cols - 2, -1, -1) if dc > 0 else range(1, cols)):
+                n = c + dc
+                if row[n] != 0:
+                    continue
+                if n == end_c or \
+                   (down is not None and down[n] == 0 and down[c] != 0) or \
+                   (up is not None and up[n] == 0 and up[c] != 0):
+                    table[c] = (r, n)
+                else:
+                    table[c] = table[n]
+            horizontal_jumps[(r, dc)] = table
+        return table
 
-        # **only** continue straight—no side‑jumps
-        return jump(nr, nc, dr, dc)
+    def jump(r, c, dr, dc):
+        if dc:
+            return horizontal(r, dc)[c]
+        # Vertical jumps stop wherever a horizontal jump from the cell would
+        # find a jump point
+        while True:
+            r += dr
+            if not passable(r, c):
+                return None
+            if (r, c) == end or horizontal(r, 1)[c] or horizontal(r, -1)[c]:
+                return (r, c)
 
     # A* over jump points
     open_heap = []
     g_score = {start: 0}
     f_score = {start: heuristic(start, end)}
     heapq.heappush(open_heap, (f_score[start], 0, start))
-    parent, visited, visited_order = {}, set(), []
+    parent, visited = {}, set()
+    if trace is None:
+        trace = SearchTrace()
+    trace.watch(open_heap, node_of=lambda item: list(item[-1]))
+    visit = trace.visitor()
+    push = trace.pusher()
 
     while open_heap:
-        _, _, current = heapq.heappop(open_heap)
+        f, _, current = heapq.heappop(open_heap)
         if current in visited:
             continue
         visited.add(current)
-        visited_order.append([current[0], current[1]])
+        if visit is not None:
+            visit(current, g_score[current], f)
         if current == end:
             break
 
+        # Jumping back the way the node was reached only finds cells its
+        # parent reaches more cheaply
+        prev = parent.get(current)
+        back = None if prev is None else ((prev[0] > current[0]) - (prev[0] < current[0]),
+                                          (prev[1] > current[1]) - (prev[1] < current[1]))
         for dr, dc in DIRS:
+            if (dr, dc) == back:
+                continue
             jp = jump(current[0], current[1], dr, dc)
             if not jp or jp in visited:
                 continue
@@ -60,17 +102,22 @@ def jump_point_search(grid, start, end):
                 g_score[jp] = tentative_g
                 f_score[jp] = tentative_g + heuristic(jp, end)
                 heapq.heappush(open_heap, (f_score[jp], tentative_g, jp))
+                if push is not None:
+                    push(jp, tentative_g, f_score[jp])
 
-    # reconstruct path
-    path = []
-    if end in parent or start == end:
-        node = end
-        while node != start:
-            path.append([node[0], node[1]])
-            node = parent.get(node)
-            if node is None:
-                break
-        path.append([start[0], start[1]])
-        path.reverse()
+    # reconstruct path, filling in the straight runs between jump points
+    with span("reconstruction"):
+        path = []
+        if end in parent or start == end:
+            node = end
+            while node != start:
+                prev = parent[node]
+                dr = (node[0] > prev[0]) - (node[0] < prev[0])
+                dc = (node[1] > prev[1]) - (node[1] < prev[1])
+                while node != prev:
+                    path.append([node[0], node[1]])
+                    node = (node[0] - dr, node[1] - dc)
+            path.append([start[0], start[1]])
+            path.reverse()
 
-    return visited_order, path
+    return trace.visited, path
@@ -0,0 +1,237 @@
+"""
+Specialized Dijkstra/A* search loops, generated per policy combination.
+
+The generic astar() and dijkstra() decide on every relaxation whether moves
+are diagonal, which heuristic to use and whether anything is traced. Here each
+combination of
+
+    moves       4 (unit cost) or 8 (octile costs, no corner cutting)
+    heuristic   "zero" (Dijkstra), "manhattan" or "octile", times an integer weight
+    traced      whether visit/push callbacks are called at all
+
+gets its own loop, generated from source with those decisions already made:
+the moves are unrolled, the heuristic is inlined and untraced loops contain no
+callback tests. The grid is copied once into a flat bytearray with a wall
+border, so neighbours are index offsets with no bounds checks. The closed set
+is a copy of those cells, so one lookup rejects both walls and expanded cells.
+
+KERNELS is the dispatch table. The combinations /api/solve can ask for are
+built at import, and others are generated on first use. astar() and dijkstra()
+below take the generic functions' arguments and return exactly what they
+would: the same visited order, path and trace callbacks (tools/fuzz.py checks
+this). They fall back to the generic functions for canonical ordering,
+non-integer weights and cell values outside 0..255.
+"""
+
+import heapq
+import threading
+
+from algorithms.astar import astar as generic_astar
+from algorithms.dijkstra import dijkstra as generic_dijkstra
+from algorithms.canonical import ALL_MOVES, CARDINALS, DIAGONAL_COST, STRAIGHT_COST
+from utils.timeline import span
+from utils.trace import SearchTrace
+
+INF = float('inf')
+
+# (moves, heuristic, weight, traced) combinations reachable from /api/solve,
+# including the weighted A* that admission control degrades to
+SOLVE_SPECS = [
+    (moves, heuristic, weight, traced)
+    for moves, heuristic, weight in ((4, "zero", 1), (4, "manhattan", 1), (4, "manhattan", 2),
+                                     (8, "zero", 1), (8, "octile", 1), (8, "octile", 2))
+    for traced in (False, True)
+]
+
+
+def _shifted(name, delta):
+    # "r", "r + 1" or "r - 1"
+    return name if not delta else f"{name} {'+' if delta > 0 else '-'} {abs(delta)}"
+
+
+def _heuristic_source(heuristic, weight, dr, dc):
+    # Heuristic of the neighbour (r + dr, c + dc), given the current cell's (r, c)
+    if heuristic == "manhattan":
+        h = f"(abs({_shifted('r', dr)} - end_r) + abs({_shifted('c', dc)} - end_c))"
+    else:
+        h = (f"(({STRAIGHT_COST} * (a - b) + {DIAGONAL_COST} * b) if a > b "
+             f"else ({STRAIGHT_COST} * (b - a) + {DIAGONAL_COST} * a))")
+    return h if weight == 1 else f"{weight} * {h}"
+
+
+def kernel_source(moves, heuristic, weight, traced):
+    """ Python source of the loop for one combination; defines `kernel`. """
+
+    dijkstra = heuristic == "zero"
+    out = [
+        "def kernel(cells, width, start, end, heap, visit, push):",
+        "    closed = bytearray(cells)",
+        "    g = {start: 0}",
+        "    parent = {}",
+        "    end_r, end_c = divmod(end, width)",
+        "    count = 0",
+        "    while heap:",
+        "        f, current = heappop(heap)" if dijkstra else "        f, _, current = heappop(heap)",
+        "        if closed[current]:",
+        "            continue",
+        "        closed[current] = 1",
+        "        g_current = g[current]",
+    ]
+    if traced:
+        out += ["        if visit is not None:",
+                "            visit(cell_of(current, width), g_current, f)"]
+    out += ["        if current == end:",
+            "            break"]
+    if not dijkstra:
+        out.append("        r, c = divmod(current, width)")
+
+    for dr, dc in (ALL_MOVES if moves == 8 else CARDINALS):
+        vertical = f" {'+' if dr > 0 else '-'} width" if dr else ""
+        horizontal = f" {'+' if dc > 0 else '-'} 1" if dc else ""
+        out.append(f"        n = current{vertical}{horizontal}")
+        test = "not closed[n]"
+        if dr and dc:
+            # No corner cutting: both cells beside the diagonal must be open
+            test += f" and not cells[current{vertical}] and not cells[current{horizontal}]"
+        cost = 1 if moves == 4 else (DIAGONAL_COST if dr and dc else STRAIGHT_COST)
+        out += [f"        if {test}:",
+                f"            ng = g_current + {cost}",
+                "            if ng < g.get(n, INF):",
+                "                parent[n] = current",
+                "                g[n] = ng"]
+        if dijkstra:
+            out += ["                f = ng",
+                    "                heappush(heap, (ng, n))"]
+        else:
+            if heuristic == "octile":
+                out += [f"                a = abs({_shifted('r', dr)} - end_r)",
+                        f"                b = abs({_shifted('c', dc)} - end_c)"]
+            out += [f"                f = ng + {_heuristic_source(heuristic, weight, dr, dc)}",
+                    "                count += 1",
+                    "                heappush(heap, (f, count, n))"]
+        if traced:
+            out += ["                if push is not None:",
+                    "                    push(cell_of(n, width), ng, f)"]
+    out.append("    return parent")
+    return "\n".join(out) + "\n"
+
+
+def cell_of(index, width):
+    """ (row, col) of a flat index into the bordered grid. """
+
+    r, c = divmod(index, width)
+    return r - 1, c - 1
+
+
+def _compile(spec):
+    source = kernel_source(*spec)
+    namespace = {"heappop": heapq.heappop, "heappush": heapq.heappush, "INF": INF, "cell_of": cell_of}
+    exec(compile(source, f"<kernel {spec}>", "exec"), namespace)
+    kernel = namespace["kernel"]
+    kernel.source = source
+    return kernel
+
+
+KERNELS = {spec: _compile(spec) for spec in SOLVE_SPECS}
+_kernels_lock = threading.Lock()
+
+
+def kernel_for(moves, heuristic, weight, traced):
+    """ The loop for one combination, generated and added to KERNELS on first use. """
+
+    spec = (moves, heuristic, weight, traced)
+    kernel = KERNELS.get(spec)
+    if kernel is None:
+        with _kernels_lock:
+            kernel = KERNELS.get(spec) or KERNELS.setdefault(spec, _compile(spec))
+    return kernel
+
+
+def bordered(grid, rows, cols):
+    """ The grid as one bytearray with a wall border: (cells, width), or None for values beyond a byte. """
+
+    width = cols + 2
+    cells = bytearray(b"\x01") * (width * (rows + 2))
+    try:
+        for r, row in enumerate(grid):
+            if len(row) != cols:
+                return None
+            cells[(r + 1) * width + 1:(r + 2) * width - 1] = bytes(row)
+    except (TypeError, ValueError):
+        return None
+    return cells, width
+
+
+def search(grid, start, end, moves, heuristic, weight, trace):
+    """
+    Run the kernel for (moves, heuristic, weight) on `grid`, or return None
+    when the grid cannot be flattened and the caller should use the generic
+    function. Validation and the output match the generic functions.
+    """
+
+    rows = len(grid)
+    cols = len(grid[0]) if rows > 0 else 0
+    for r, c in (start, end):
+        if not (0 <= r < rows and 0 <= c < cols):
+            return [], []
+    if grid[start[0]][start[1]] == 1 or grid[end[0]][end[1]] == 1:
+        return [], []
+    flat = bordered(grid, rows, cols)
+    if flat is None:
+        return None
+    cells, width = flat
+    source, target = (start[0] + 1) * width + start[1] + 1, (end[0] + 1) * width + end[1] + 1
+    if cells[source] or cells[target]:
+        return None   # cell values other than 0 and 1: leave them to the generic rules
+
+    if trace is None:
+        trace = SearchTrace()
+    if heuristic == "zero":
+        heap = [(0, source)]
+    else:
+        sr, sc = divmod(source, width)
+        er, ec = divmod(target, width)
+        dy, dx = abs(sr - er), abs(sc - ec)
+        if heuristic == "manhattan":
+            h = dy + dx
+        else:
+            h = STRAIGHT_COST * abs(dy - dx) + DIAGONAL_COST * min(dy, dx)
+        heap = [(weight * h, 0, source)]
+    trace.watch(heap, node_of=lambda item: list(cell_of(item[-1], width)))
+    visit = trace.visitor()
+    push = trace.pusher()
+
+    kernel = kernel_for(moves, heuristic, weight, visit is not None or push is not None)
+    parent = kernel(cells, width, source, target, heap, visit, push)
+
+    with span("reconstruction"):
+        path = []
+        if target in parent or source == target:
+            node = target
+            while node != source:
+                path.append(list(cell_of(node, width)))
+                node = parent[node]
+            path.append([start[0], start[1]])
+            path.reverse()
+    return trace.visited, path
+
+
+def astar(grid, start, end, diagonal=False, canonical=False, weight=1, trace=None):
+    """ algorithms.astar.astar() through a specialized kernel where one applies. """
+
+    if not canonical and isinstance(weight, int):
+        result = search(grid, start, end, 8 if diagonal else 4, "octile" if diagonal else "manhattan",
+                        weight, trace)
+        if result is not None:
+            return result
+    return generic_astar(grid, start, end, diagonal=diagonal, canonical=canonical, weight=weight, trace=trace)
+
+
+def dijkstra(grid, start, end, diagonal=False, canonical=False, trace=None):
+    """ algorithms.dijkstra.dijkstra() through a specialized kernel where one applies. """
+
+    if not canonical:
+        result = search(grid, start, end, 8 if diagonal else 4, "zero", 1, trace)
+        if result is not None:
+            return result
+    return generic_dijkstra(grid, start, end, diagonal=diagonal, canonical=canonical, trace=trace)
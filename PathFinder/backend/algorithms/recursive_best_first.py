@@ -1,12 +1,53 @@
-""" Recursive Best‑First Search (RBFS) implementation for the pathfinding visualizer. """
+"""
+Recursive Best‑First Search (RBFS) implementation for the pathfinding visualizer.
+
+RBFS keeps only the current path in memory and re-expands nodes on other
+branches, so its run time can grow exponentially with the grid. It refuses
+grids above MAX_CELLS, answers unreachable goals with a flood fill before
+searching, and gives up with SearchLimitError after MAX_EXPANSIONS expansions.
+"""
 
 import math
 import sys
+from collections import deque
+
+from utils.trace import SearchTrace
+
 sys.setrecursionlimit(10000)
 
-def recursive_best_first(grid, start, end):
+MAX_CELLS = 100 * 100
+MAX_EXPANSIONS = 100_000
+
+
+class SearchLimitError(ValueError):
+    """ The search stopped at its expansion limit without an answer. """
+
+
+def check_size(rows, cols):
+    """ Raise ValueError for a grid too large for RBFS. """
+
+    if rows * cols > MAX_CELLS:
+        raise ValueError(f"rbfs is limited to {MAX_CELLS} cells; the grid has {rows * cols}.")
+
+
+def _reachable(grid, rows, cols, start, end):
+    seen = {start}
+    queue = deque([start])
+    while queue:
+        r, c = queue.popleft()
+        if (r, c) == end:
+            return True
+        for nr, nc in ((r - 1, c), (r, c + 1), (r + 1, c), (r, c - 1)):
+            if 0 <= nr < rows and 0 <= nc < cols and grid[nr][nc] == 0 and (nr, nc) not in seen:
+                seen.add((nr, nc))
+                queue.append((nr, nc))
+    return False
+
+
+def recursive_best_first(grid, start, end, trace=None):
     rows = len(grid)
     cols = len(grid[0]) if rows > 0 else 0
+    check_size(rows, cols)
 
     def in_bounds(r, c):
         return 0 <= r < rows and 0 <= c < cols
@@ -23,14 +64,37 @@ def recursive_best_first(grid, start, end):
     if grid[start[0]][start[1]] == 1 or grid[end[0]][end[1]] == 1:
         return [], []
 
-    visited_order = []
+    if trace is None:
+        trace = SearchTrace()
+    start, end = tuple(start), tuple(end)
+    # Without a path RBFS would re-expand every branch at ever higher limits
+    if not _reachable(grid, rows, cols, start, end):
+        return trace.visited, []
+    visit = trace.visitor()
+    # Nodes on the current recursion path; RBFS re-expands nodes on other branches
+    on_path = set()
+    expansions = 0
 
     directions = [(-1,0),(0,1),(1,0),(0,-1)]
 
-    def rbfs(node, g, f_limit):
-        visited_order.append([node[0], node[1]])
+    # f_stored is the node's backed-up f value: at least g + h, raised when an
+    # earlier pass below it gave up; f_limit is the best alternative elsewhere
+    def rbfs(node, g, f_stored, f_limit):
+        on_path.add(node)
+        try:
+            return expand(node, g, f_stored, f_limit)
+        finally:
+            on_path.discard(node)
+
+    def expand(node, g, f_stored, f_limit):
+        nonlocal expansions
+        expansions += 1
+        if expansions > MAX_EXPANSIONS:
+            raise SearchLimitError(f"rbfs gave up after {MAX_EXPANSIONS} expansions; try astar.")
         h = heuristic(node, end)
-        f = max(g + h, f_limit)
+        f = max(g + h, f_stored)
+        if visit is not None:
+            visit(node, g, f)
 
         if node == end:
             return True, f, [node]
@@ -40,8 +104,8 @@ def recursive_best_first(grid, start, end):
             nr, nc = node[0] + dr, node[1] + dc
             if is_passable(nr, nc):
                 neighbor = (nr, nc)
-                # note: we don't re‑visit nodes already expanded
-                if [nr, nc] not in visited_order:
+                # no cycles back onto the current path
+                if neighbor not in on_path:
                     h2 = heuristic(neighbor, end)
                     successors.append([neighbor, max(g + 1 + h2, f)])
 
@@ -52,11 +116,11 @@ def recursive_best_first(grid, start, end):
 
         while successors:
             best, f_best = successors[0]
-            if f_best > f_limit:
+            if f_best > f_limit or f_best == math.inf:
                 return False, f_best, []
             alt = successors[1][1] if len(successors) > 1 else math.inf
 
-            found, new_f, path = rbfs(best, g + 1, min(f_limit, alt))
+            found, new_f, path = rbfs(best, g + 1, f_best, min(f_limit, alt))
             successors[0][1] = new_f
             successors.sort(key=lambda x: x[1])
             if found:
@@ -64,6 +128,6 @@ def recursive_best_first(grid, start, end):
 
         return False, math.inf, []
 
-    _, _, full_path = rbfs(start, 0, math.inf)
+    _, _, full_path = rbfs(start, 0, heuristic(start, end), math.inf)
     # convert to list-of-lists for JSON
-    return visited_order, [[r, c] for r, c in full_path]
\ No newline at end of file
+    return trace.visited, [[r, c] for r, c in full_path]
\ No newline at end of file
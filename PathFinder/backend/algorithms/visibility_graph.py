@@ -0,0 +1,442 @@
+"""
+Visibility-graph any-angle search for the pathfinding visualizer.
+
+Functions:
+    visibility_graph_search(grid, start, end, graph=None, trace=None):
+        - grid: 2D list of ints where 0 = empty cell, 1 = wall
+        - start: tuple (row, col) for the starting cell
+        - end: tuple (row, col) for the ending cell
+        - graph: optional prebuilt VisibilityGraph of `grid` (e.g. a stored map's derived table)
+        - trace: optional SearchTrace choosing what visited_order records (default: every expansion)
+        Returns a tuple (visited_order, path):
+            visited_order: list of [row, col] graph vertices in the order they are expanded
+            path: list of [row, col] cells along the any-angle path from start to end (inclusive),
+                  or empty list if no path exists
+
+The convex wall corners of a grid and their mutual visibility are computed once
+and cached; a query only links start and end to the corners they can see and
+runs A* (Euclidean heuristic) over the resulting graph. When the same-sized grid
+comes back with a few walls changed, a patched copy of the cached graph replaces
+it instead of a full rebuild. A graph is never modified once searches can see it.
+
+The cache for inline grids keeps the latest graph of up to MAX_CACHED_SHAPES
+grid shapes and charges each one to the residency budget (utils/residency.py)
+as an artifact of "visibility_graph". One request per shape builds at a time;
+others asking for the same shape wait for its graph, and other shapes proceed.
+"""
+
+import heapq
+import math
+import os
+import sys
+import threading
+from array import array
+from collections import OrderedDict
+from concurrent.futures import ProcessPoolExecutor
+
+from utils.line_of_sight import pack_rows, line_of_sight, segment_cells
+from utils.residency import residency
+from utils.timeline import span
+from utils.trace import SearchTrace
+
+# Corner counts above this are split across worker processes when building
+PARALLEL_BUILD_MIN_CORNERS = 600
+
+# Patch the cached graph only while the edit touches at most this many cells
+INCREMENTAL_MAX_CHANGED = 64
+
+# Grid shapes whose latest graph the inline-grid cache keeps
+MAX_CACHED_SHAPES = 8
+CACHE_OWNER = "visibility_graph"
+
+DIAGONALS = [(-1, -1), (-1, 1), (1, -1), (1, 1)]
+
+
+def _is_free(packed, rows, cols, r, c):
+    return 0 <= r < rows and 0 <= c < cols and not (packed[r] >> c) & 1
+
+
+def _is_corner(packed, rows, cols, r, c):
+    # A free cell diagonally next to a wall whose two shared sides are open
+    if not _is_free(packed, rows, cols, r, c):
+        return False
+    for dr, dc in DIAGONALS:
+        nr, nc = r + dr, c + dc
+        if (0 <= nr < rows and 0 <= nc < cols and (packed[nr] >> nc) & 1
+                and _is_free(packed, rows, cols, nr, c)
+                and _is_free(packed, rows, cols, r, nc)):
+            return True
+    return False
+
+
+_pool = None
+_pool_lock = threading.Lock()
+
+
+def _build_pool(workers):
+    # One worker pool for every parallel build in this process, started on first use
+    global _pool
+    with _pool_lock:
+        if _pool is None:
+            _pool = ProcessPoolExecutor(max_workers=workers)
+        return _pool
+
+
+def _distance(a, b):
+    return math.hypot(a[0] - b[0], a[1] - b[1])
+
+
+def _visible_pairs(packed, corners, lo, hi):
+    # Edges (i, j) with lo <= i < hi and j > i; runs inside worker processes
+    pairs = []
+    for i in range(lo, hi):
+        a = corners[i]
+        for j in range(i + 1, len(corners)):
+            if line_of_sight(packed, a, corners[j]):
+                pairs.append((i, j))
+    return pairs
+
+
+def _in_box(cell, a, b):
+    return (min(a[0], b[0]) <= cell[0] <= max(a[0], b[0])
+            and min(a[1], b[1]) <= cell[1] <= max(a[1], b[1]))
+
+
+class VisibilityGraph:
+    """ Convex corners of one grid and the visibility edges between them. """
+
+    def __init__(self, grid):
+        self.rows = len(grid)
+        self.cols = len(grid[0]) if self.rows > 0 else 0
+        self.packed = pack_rows(grid)
+        self.edges = {}
+        self._build()
+
+    def _build(self):
+        rows, cols, packed = self.rows, self.cols, self.packed
+        corners = [(r, c) for r in range(rows) for c in range(cols)
+                   if _is_corner(packed, rows, cols, r, c)]
+        self.edges = {corner: {} for corner in corners}
+
+        if len(corners) >= PARALLEL_BUILD_MIN_CORNERS and (os.cpu_count() or 1) > 1:
+            workers = os.cpu_count()
+            # Row i checks n - i - 1 pairs, so cut chunks by equal pair counts
+            n = len(corners)
+            chunks = workers * 4
+            bounds = [0]
+            for k in range(1, chunks):
+                bounds.append(int(n - n * math.sqrt(1 - k / chunks)))
+            bounds.append(n)
+            pool = _build_pool(workers)
+            futures = [pool.submit(_visible_pairs, packed, corners, lo, hi)
+                       for lo, hi in zip(bounds, bounds[1:]) if lo < hi]
+            pair_lists = [f.result() for f in futures]
+        else:
+            pair_lists = [_visible_pairs(packed, corners, 0, len(corners))]
+
+        for pairs in pair_lists:
+            for i, j in pairs:
+                self._link(corners[i], corners[j])
+
+    def _link(self, a, b):
+        d = _distance(a, b)
+        self.edges[a][b] = d
+        self.edges[b][a] = d
+
+    def _drop_corner(self, corner):
+        for other in self.edges.pop(corner):
+            del self.edges[other][corner]
+
+    def _add_corner(self, corner):
+        self.edges[corner] = {}
+        for other in list(self.edges):
+            if other != corner and line_of_sight(self.packed, corner, other):
+                self._link(corner, other)
+
+    def memory_bytes(self):
+        """ Rough size in bytes of the graph's Python objects. """
+
+        size = sys.getsizeof(self.edges) + sum(sys.getsizeof(row) for row in self.packed)
+        for corner, nbrs in self.edges.items():
+            # Each distance float is shared by the two directions of its edge
+            size += sys.getsizeof(corner) + sys.getsizeof(nbrs) + sys.getsizeof(0.0) * len(nbrs) // 2
+        return size
+
+    def to_sections(self):
+        """
+        The graph as flat arrays, for the table cache: corner (row, col) pairs,
+        then adjacency in CSR form (offsets, neighbour corner indices, distances).
+        """
+
+        corners = list(self.edges)
+        index = {corner: i for i, corner in enumerate(corners)}
+        flat = array("i")
+        offsets = array("I", [0])
+        neighbors = array("I")
+        distances = array("d")
+        for corner in corners:
+            flat.extend(corner)
+            nbrs = self.edges[corner]
+            neighbors.extend(index[other] for other in nbrs)
+            distances.extend(nbrs.values())
+            offsets.append(len(neighbors))
+        return [flat, offsets, neighbors, distances]
+
+    @classmethod
+    def from_sections(cls, grid, sections):
+        """ Rebuild the graph of `grid` from to_sections() output (arrays or memoryviews). """
+
+        flat, offsets, neighbors, distances = sections
+        graph = cls.__new__(cls)
+        graph.rows = len(grid)
+        graph.cols = len(grid[0]) if graph.rows > 0 else 0
+        graph.packed = pack_rows(grid)
+        corners = list(zip(flat[0::2], flat[1::2]))
+        graph.edges = {}
+        for i, corner in enumerate(corners):
+            lo, hi = offsets[i], offsets[i + 1]
+            graph.edges[corner] = dict(zip([corners[j] for j in neighbors[lo:hi]], distances[lo:hi]))
+        return graph
+
+    def copy(self):
+        """ An independent copy, for patching without disturbing searches on this one. """
+
+        graph = VisibilityGraph.__new__(VisibilityGraph)
+        graph.rows, graph.cols, graph.packed = self.rows, self.cols, self.packed
+        graph.edges = {corner: dict(nbrs) for corner, nbrs in self.edges.items()}
+        return graph
+
+    def update(self, grid, changed):
+        """
+        Patch the graph for a grid that differs from the cached one only at `changed`
+        cells. Edges through new walls are dropped, pairs whose bounding box covers a
+        removed wall are re-tested, and corner status is refreshed around every edit.
+        """
+
+        rows, cols = self.rows, self.cols
+        old_packed = self.packed
+        self.packed = pack_rows(grid)
+
+        added = [cell for cell in changed if (self.packed[cell[0]] >> cell[1]) & 1]
+        removed = [cell for cell in changed if (old_packed[cell[0]] >> cell[1]) & 1]
+
+        # Corner status can only change within one cell of an edit
+        touched = {(r + dr, c + dc) for r, c in changed
+                   for dr in (-1, 0, 1) for dc in (-1, 0, 1)}
+        for cell in touched:
+            if not (0 <= cell[0] < rows and 0 <= cell[1] < cols):
+                continue
+            was = cell in self.edges
+            now = _is_corner(self.packed, rows, cols, *cell)
+            if was and not now:
+                self._drop_corner(cell)
+
+        if added:
+            for a, nbrs in self.edges.items():
+                for b in [b for b in nbrs
+                          if any(_in_box(cell, a, b) for cell in added)
+                          and not line_of_sight(self.packed, a, b)]:
+                    del nbrs[b]
+
+        if removed:
+            corners = list(self.edges)
+            for i, a in enumerate(corners):
+                nbrs = self.edges[a]
+                for b in corners[i + 1:]:
+                    if (b not in nbrs and any(_in_box(cell, a, b) for cell in removed)
+                            and line_of_sight(self.packed, a, b)):
+                        self._link(a, b)
+
+        for cell in touched:
+            if (0 <= cell[0] < rows and 0 <= cell[1] < cols and cell not in self.edges
+                    and _is_corner(self.packed, rows, cols, *cell)):
+                self._add_corner(cell)
+
+    def visible_corners(self, cell):
+        return {corner: _distance(cell, corner) for corner in self.edges
+                if corner != cell and line_of_sight(self.packed, cell, corner)}
+
+
+def derive_visibility_graph(grid, previous=None):
+    """
+    The graph for `grid`: `previous` itself if it already matches, a patched
+    copy of it when only a few cells changed, otherwise a fresh build.
+    """
+
+    rows = len(grid)
+    cols = len(grid[0]) if rows > 0 else 0
+    if previous is None or (previous.rows, previous.cols) != (rows, cols):
+        return VisibilityGraph(grid)
+    packed = pack_rows(grid)
+    if previous.packed == packed:
+        return previous
+    changed = []
+    for r, (old, new) in enumerate(zip(previous.packed, packed)):
+        diff = old ^ new
+        while diff and len(changed) <= INCREMENTAL_MAX_CHANGED:
+            low = diff & -diff
+            changed.append((r, low.bit_length() - 1))
+            diff ^= low
+    if len(changed) > INCREMENTAL_MAX_CHANGED:
+        return VisibilityGraph(grid)
+    graph = previous.copy()
+    graph.update(grid, changed)
+    return graph
+
+
+# Most recent graph per grid shape, reused across requests that send the grid
+# inline; least recently used first
+_graph_cache = OrderedDict()
+# Shape -> Event set when the build in progress for it finishes
+_graph_builds = {}
+_graph_lock = threading.Lock()
+
+
+def _shape_name(shape):
+    return f"graph {shape[0]}x{shape[1]}"
+
+
+def _evict_graph(shape, graph):
+    # Residency eviction callback
+    with _graph_lock:
+        if _graph_cache.get(shape) is graph:
+            del _graph_cache[shape]
+
+
+def get_visibility_graph(grid):
+    """ Return the cached graph for `grid`, patching or rebuilding it as needed. """
+
+    rows = len(grid)
+    cols = len(grid[0]) if rows > 0 else 0
+    shape = (rows, cols)
+    packed = pack_rows(grid)
+    while True:
+        with _graph_lock:
+            previous = _graph_cache.get(shape)
+            if previous is not None and previous.packed == packed:
+                _graph_cache.move_to_end(shape)
+                break
+            building = _graph_builds.get(shape)
+            if building is None:
+                done = _graph_builds[shape] = threading.Event()
+                break
+        # Another request is building this shape; its graph may be the one we need
+        building.wait()
+    if previous is not None and previous.packed == packed:
+        residency.touch(CACHE_OWNER, _shape_name(shape))
+        return previous
+
+    try:
+        graph = derive_visibility_graph(grid, previous)
+        with _graph_lock:
+            _graph_cache[shape] = graph
+            _graph_cache.move_to_end(shape)
+            dropped = []
+            while len(_graph_cache) > MAX_CACHED_SHAPES:
+                dropped.append(_graph_cache.popitem(last=False)[0])
+    finally:
+        with _graph_lock:
+            del _graph_builds[shape]
+        done.set()
+    for old in dropped:
+        residency.release(CACHE_OWNER, _shape_name(old))
+    residency.charge(CACHE_OWNER, _shape_name(shape), graph.memory_bytes(),
+                     lambda: _evict_graph(shape, graph))
+    return graph
+
+
+def visibility_graph_search(grid, start, end, graph=None, trace=None):
+    rows = len(grid)
+    cols = len(grid[0]) if rows > 0 else 0
+
+    def in_bounds(r, c):
+        return 0 <= r < rows and 0 <= c < cols
+
+    # Validate start/end
+    if not in_bounds(*start) or not in_bounds(*end):
+        return [], []
+    if grid[start[0]][start[1]] == 1 or grid[end[0]][end[1]] == 1:
+        return [], []
+
+    start, end = tuple(start), tuple(end)
+    if graph is None:
+        graph = get_visibility_graph(grid)
+    packed = graph.packed
+
+    if trace is None:
+        trace = SearchTrace()
+    visit = trace.visitor()
+    push = trace.pusher()
+
+    if start == end or line_of_sight(packed, start, end):
+        if visit is not None:
+            visit(start, 0, _distance(start, end))
+            if start != end:
+                visit(end, _distance(start, end), _distance(start, end))
+        return trace.visited, segment_cells(start, end)
+
+    start_links = graph.visible_corners(start)
+    end_links = graph.visible_corners(end)
+
+    def neighbors(node):
+        if node == start:
+            return start_links.items()
+        links = graph.edges.get(node, {})
+        if node in end_links:
+            return list(links.items()) + [(end, end_links[node])]
+        return links.items()
+
+    # A* over corners: (f_score, count, node)
+    g_score = {start: 0}
+    open_heap = [(_distance(start, end), 0, start)]
+    parent = {}
+    visited = set()
+    trace.watch(open_heap, node_of=lambda item: list(item[-1]))
+    count = 0
+
+    while open_heap:
+        f, _, current = heapq.heappop(open_heap)
+        if current in visited:
+            continue
+        visited.add(current)
+        if visit is not None:
+            visit(current, g_score[current], f)
+        if current == end:
+            break
+
+        for neighbor, d in neighbors(current):
+            if neighbor in visited:
+                continue
+            tentative_g = g_score[current] + d
+            if tentative_g < g_score.get(neighbor, float('inf')):
+                g_score[neighbor] = tentative_g
+                parent[neighbor] = current
+                count += 1
+                f = tentative_g + _distance(neighbor, end)
+                heapq.heappush(open_heap, (f, count, neighbor))
+                if push is not None:
+                    push(neighbor, tentative_g, f)
+
+    # Reconstruct path, expanding every straight leg into grid cells
+    with span("reconstruction"):
+        path = []
+        if end in parent:
+            waypoints = [end]
+            while waypoints[-1] != start:
+                waypoints.append(parent[waypoints[-1]])
+            waypoints.reverse()
+            position = {}   # cell -> its index in path
+            for a, b in zip(waypoints, waypoints[1:]):
+                for cell in segment_cells(a, b)[1 if path else 0:]:
+                    key = (cell[0], cell[1])
+                    if key in position:
+                        # Rasterized legs can overlap where they meet: cut the loop
+                        # back to the earlier visit, which keeps the path 4-connected
+                        for dropped in path[position[key] + 1:]:
+                            del position[(dropped[0], dropped[1])]
+                        del path[position[key] + 1:]
+                    else:
+                        position[key] = len(path)
+                        path.append(cell)
+
+    return trace.visited, path
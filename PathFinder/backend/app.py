@@ -1,81 +1,621 @@
 """
 Flask backend for the Pathfinding Visualizer.
 Defines the `/api/solve` endpoint, dispatches to the selected algorithm,
-and returns the exploration order and final path for animation.
+and returns the exploration order and final path for animation. `/api/maps`
+keeps server-side copies of edited maps so solves can reference them by id,
+and reuses each map version's derived tables (utils/derived.py) across solves.
+`/api/jobs` runs the same work in the background for searches too slow for
+one request. Synchronous searches go through admission control
+(utils/admission.py); `/api/metrics` reports its queues. A solve or trace
+sent with `X-Timeline: 1` records per-phase timings (utils/timeline.py),
+served from `/api/timelines/<id>`.
 """
 
-from flask import Flask, request, jsonify
+import json
+from functools import partial, wraps
+
+from flask import Flask, Response, request, jsonify
 from flask_cors import CORS
 
-# Import all algorithms
-from algorithms.bfs import bfs
-from algorithms.dfs import dfs
-from algorithms.dijkstra import dijkstra
+from algorithms import ALGORITHMS, OPTIONS, check_grid_size, check_options
+from algorithms.recursive_best_first import SearchLimitError
 from algorithms.astar import astar
-from algorithms.bidirectional import bidirectional_search
-from algorithms.greedy_best_first import greedy_best_first
-from algorithms.jump_point_search import jump_point_search
-from algorithms.recursive_best_first import recursive_best_first
+from algorithms.kernels import astar as astar_kernel
+from utils.trace import SearchTrace, DEFAULT_SAMPLE_EVERY
+from utils.trace_file import encode_trace
+from utils.map_store import map_store, encode_runs, UnknownMapError, VersionConflictError
+from utils.map_generators import generate
+from utils.jobs import job_queue, QueueFullError, UnknownJobError, FINISHED_STATES
+from utils.single_flight import SingleFlight, content_key
+from utils.admission import admission, OverloadedError, PRIORITIES
+from utils.derived import ALGORITHM_TABLES
+from utils.table_cache import table_cache
+from utils.residency import residency
+from utils.timeline import span, begin as begin_timeline, end as end_timeline, timelines
 
 
 # Initialize Flask app and enable CORS for local development
 app = Flask(__name__)
-CORS(app)
-
-# Mapping of algorithm keys to functions
-ALGORITHMS = {
-    "bfs": bfs,
-    "dfs": dfs,
-    "dijkstra": dijkstra,
-    "astar": astar,
-    "bidirectional": bidirectional_search,
-    "gbfs": greedy_best_first,
-    "jps": jump_point_search,
-    "rbfs": recursive_best_first,
+CORS(app, expose_headers=["X-Timeline-Id"])
+
+# Identical solves and traces in flight at the same time share one computation
+coalescer = SingleFlight()
+
+# Cheaper stand-ins used when admission control degrades a busy request
+DEGRADED_WEIGHT = 2
+DEGRADED_ALGORITHMS = {
+    "dijkstra": partial(astar_kernel, weight=DEGRADED_WEIGHT),
+    "astar": partial(astar_kernel, weight=DEGRADED_WEIGHT),
+    "dijkstra_8": partial(astar_kernel, diagonal=True, weight=DEGRADED_WEIGHT),
+    "canonical_dijkstra": partial(astar, diagonal=True, canonical=True, weight=DEGRADED_WEIGHT),
+    "astar_8": partial(astar_kernel, diagonal=True, weight=DEGRADED_WEIGHT),
+    "canonical_astar": partial(astar, diagonal=True, canonical=True, weight=DEGRADED_WEIGHT),
 }
 
+def _request_source(data):
+    """ (grid, snapshot) for a payload; the snapshot is None for an inline grid. """
+
+    if "map_id" in data:
+        with span("cache lookup", map_id=data["map_id"]):
+            snapshot = map_store.get(data["map_id"])
+        return snapshot.grid, snapshot
+    return data["grid"], None
+
+def _with_tables(data, algo_fn, snapshot):
+    """ For a stored map, hand algorithms that take one the snapshot's derived table (built on first use). """
+
+    entry = ALGORITHM_TABLES.get(data.get("algorithm", "astar").lower())
+    if snapshot is None or entry is None:
+        return algo_fn
+    name, keyword = entry
+
+    def run_with_table(grid, start, end, trace=None):
+        with span("preprocess", table=name):
+            table = snapshot.table(name)
+        return algo_fn(grid, start, end, trace=trace, **{keyword: table})
+    return run_with_table
+
+def _request_key(kind, run):
+    """
+    Coalescing key: the raw request body, plus the version of the stored map
+    snapshot `run` searches (from _solve_request/_trace_request).
+    """
+
+    return content_key(kind, request.get_data(), run.version)
+
+def _resolved(run, grid, snapshot):
+    """ Tag a request's `run` with what it will search: the map version and the cell count. """
+
+    run.version = snapshot.version if snapshot is not None else None
+    run.cells = len(grid) * (len(grid[0]) if grid else 0)
+    return run
+
+def _encode_json(result):
+    with span("serialize"):
+        return json.dumps(result, separators=(",", ":")).encode()
+
+def _algorithm(data, grid):
+    algo_name = data.get("algorithm", "astar").lower()
+    algo_fn = ALGORITHMS.get(algo_name)
+    if algo_fn is None:
+        raise ValueError(f"Unknown algorithm '{algo_name}'")
+    check_grid_size(algo_name, grid)
+    if data.get("priority", "interactive") not in PRIORITIES:
+        raise ValueError(f"Unknown priority '{data['priority']}'. Supported: {PRIORITIES}.")
+    options = {name: data[name] for name in OPTIONS.get(algo_name, {}) if name in data}
+    if options:
+        check_options(algo_name, options)
+        algo_fn = partial(algo_fn, **options)
+    return algo_fn
+
+def _run_admitted(data, cells, run, trace_level, can_degrade=True, priority=None, can_shed=True):
+    """
+    Call `run(degraded)` once admission control gives the payload, which
+    searches `cells` cells, a search slot in class `priority` (default: the
+    payload's); raises OverloadedError if the request is shed instead.
+    """
+
+    with span("admission wait"):
+        ticket = admission.acquire(priority or data.get("priority", "interactive"),
+                                   data.get("algorithm", "astar").lower(),
+                                   cells, trace_level, can_degrade, can_shed)
+    try:
+        return run(ticket.degraded)
+    finally:
+        ticket.release()
+
+def _overloaded(e, status=503):
+    response = jsonify({"error": str(e)})
+    response.headers["Retry-After"] = str(e.retry_after)
+    return response, status
+
+def _solve_request(data):
+    """
+    Check a solve payload and return `run(progress=None, degraded=False)`,
+    which performs the search and returns the response dict; `run.version`
+    and `run.cells` describe the grid it captured. Raises KeyError, ValueError
+    or UnknownMapError for a bad payload.
+    """
+
+    grid, snapshot = _request_source(data)
+    start = tuple(data["start"])
+    end = tuple(data["end"])
+    algo_fn = _with_tables(data, _algorithm(data, grid), snapshot)
+    degraded_fn = DEGRADED_ALGORITHMS.get(data.get("algorithm", "astar").lower(), algo_fn)
+    trace_level = data.get("trace", "full")
+    sample_every = data.get("sample_every", DEFAULT_SAMPLE_EVERY)
+    # Checked now, so a bad level fails the request rather than a queued job
+    SearchTrace(trace_level, sample_every)
+
+    def run(progress=None, degraded=False):
+        level = "none" if degraded else trace_level
+        trace = SearchTrace(level, sample_every, progress=progress)
+        fn = degraded_fn if degraded else algo_fn
+        with span("search", algorithm=data.get("algorithm", "astar").lower(), degraded=degraded):
+            visited_order, shortest_path = fn(grid, start, end, trace=trace)
+        result = {
+            "visited": visited_order,
+            "path": shortest_path
+        }
+        if trace.level == "frontier":
+            result["frontier"] = trace.frontier
+        if degraded:
+            result["degraded"] = True
+        return result
+    return _resolved(run, grid, snapshot)
+
+def _trace_request(data):
+    """ Like _solve_request, for a binary trace file: `run(progress=None)` returns its bytes. """
+
+    grid, snapshot = _request_source(data)
+    start = tuple(data["start"])
+    end = tuple(data["end"])
+    algo_fn = _with_tables(data, _algorithm(data, grid), snapshot)
+
+    def run(progress=None):
+        trace = SearchTrace("none", record=True, progress=progress)
+        with span("search", algorithm=data.get("algorithm", "astar").lower()):
+            _, shortest_path = algo_fn(grid, start, end, trace=trace)
+        with span("serialize"):
+            return encode_trace(grid, start, end, trace.recorder, shortest_path)
+    return _resolved(run, grid, snapshot)
+
+def _generate_request(data):
+    """ Check a generate payload and return `run()`, which builds and stores the map. """
+
+    rows, cols = data["rows"], data["cols"]
+    kind = data["generator"]
+    seed = data.get("seed", 0)
+    params = data.get("params", {})
+    if not isinstance(params, dict):
+        raise ValueError("params must be an object.")
+
+    def run():
+        grid = generate(kind, rows, cols, seed, **params)
+        snapshot = map_store.store(rows, cols, grid)
+        return {
+            "map_id": snapshot.map_id,
+            "version": snapshot.version,
+            "rows": rows,
+            "cols": cols,
+            "runs": encode_runs(grid),
+        }
+    return run
+
+def _timed(view):
+    """
+    Record a timeline for requests sent with `X-Timeline: 1`. The response
+    carries its id in `X-Timeline-Id`; the "response write" span ends once the
+    server has handed the last body chunk to the connection.
+    """
+
+    @wraps(view)
+    def timed_view(*args, **kwargs):
+        if request.headers.get("X-Timeline") != "1":
+            return view(*args, **kwargs)
+        timeline = begin_timeline(f"{request.method} {request.path}")
+        try:
+            with span("handler"):
+                response = app.make_response(view(*args, **kwargs))
+        finally:
+            end_timeline()
+        chunks = response.response
+
+        def write():
+            with timeline.span("response write"):
+                yield from chunks
+        response.response = write()
+        response.headers["X-Timeline-Id"] = timeline.timeline_id
+        return response
+    return timed_view
+
 @app.route("/api/solve", methods=["POST"])
+@_timed
 def solve():
     """
     Expects a JSON payload:
     {
         "grid": List[List[int]],  # 0 = empty, 1 = wall
+        "map_id": str,            # alternative to "grid": a map stored via /api/maps
         "start": [row, col],
         "end": [row, col],
-        "algorithm": str        # one of: bfs, dfs, dijkstra, astar, bidirectional
+        "algorithm": str,       # one of: bfs, dfs, dijkstra, astar, bidirectional
+        "trace": str,           # optional: none, sampled, frontier or full (default)
+        "sample_every": int,    # optional: expansions between samples/snapshots
+        "priority": str,        # optional: interactive (default) or batch
+        "block_size": int       # optional, block_astar only: block side from 2 to 8 (default 4)
     }
+    With the header `X-Timeline: 1` the response also carries `X-Timeline-Id`
+    (see /api/timelines/<id>).
 
     Returns:
     {
-        "visited": [[r, c], ...],  # order of node visits
-        "path": [[r, c], ...]      # final reconstructed path
+        "visited": [[r, c], ...],  # order of node visits ([r, c, h, w] blocks for block_astar)
+        "path": [[r, c], ...],     # final reconstructed path
+        "frontier": [[i, [[r, c], ...]], ...],  # only for trace "frontier": open list at expansion i
+        "degraded": true           # only when the server was busy: no trace, and the A*/Dijkstra
+                                   # family ran as weighted A* (path may be longer than shortest)
     }
+    Returns 503 with Retry-After when the server is too busy to take the request.
+    """
+    try:
+        with span("parse"):
+            data = request.get_json(force=True)
+        try:
+            with span("validate"):
+                run = _solve_request(data)
+        except ValueError as e:
+            return jsonify({"error": str(e)}), 400
+
+        # Run the algorithm; concurrent identical requests wait for this one's bytes
+        trace_level = data.get("trace", "full")
+        with span("single-flight"):
+            body = coalescer.do(_request_key("solve", run), lambda: _run_admitted(
+                data, run.cells, lambda degraded: _encode_json(run(degraded=degraded)), trace_level))
+        return Response(body, mimetype="application/json")
+
+    except OverloadedError as e:
+        return _overloaded(e)
+    except UnknownMapError as e:
+        return jsonify({"error": str(e)}), 404
+    except SearchLimitError as e:
+        return jsonify({"error": str(e)}), 400
+    except KeyError as e:
+        return jsonify({"error": f"Missing required field: {e.args[0]}"}), 400
+    except Exception as e:
+        app.logger.exception("Error during pathfinding")
+        return jsonify({"error": str(e)}), 500
+
+@app.route("/api/trace", methods=["POST"])
+@_timed
+def record_trace():
+    """
+    Accepts the same payload as `/api/solve` and returns the run as a binary
+    trace file (application/octet-stream, format in utils/trace_file.py) with
+    every expansion and push and their g/f values, for offline replay.
+    """
+    try:
+        with span("parse"):
+            data = request.get_json(force=True)
+        try:
+            with span("validate"):
+                run = _trace_request(data)
+        except ValueError as e:
+            return jsonify({"error": str(e)}), 400
+
+        # Never degraded: the full recording is the point
+        with span("single-flight"):
+            body = coalescer.do(_request_key("trace", run), lambda: _run_admitted(
+                data, run.cells, lambda degraded: run(), "full", can_degrade=False))
+        return Response(body, mimetype="application/octet-stream")
+
+    except OverloadedError as e:
+        return _overloaded(e)
+    except UnknownMapError as e:
+        return jsonify({"error": str(e)}), 404
+    except SearchLimitError as e:
+        return jsonify({"error": str(e)}), 400
+    except KeyError as e:
+        return jsonify({"error": f"Missing required field: {e.args[0]}"}), 400
+    except Exception as e:
+        app.logger.exception("Error during trace recording")
+        return jsonify({"error": str(e)}), 500
+
+@app.route("/api/maps", methods=["POST"])
+def create_map():
+    """
+    Store a map for later deltas and solves. Expects:
+    {
+        "rows": int,
+        "cols": int,
+        "runs": [start, length, value, ...]  # optional, applied to an empty map
+    }
+    Returns (201): { "map_id": str, "version": 0 }
     """
     try:
         data = request.get_json(force=True)
-        grid = data["grid"]
-        start = tuple(data["start"])
-        end = tuple(data["end"])
-        algo_name = data.get("algorithm", "astar").lower()
+        snapshot = map_store.create(data["rows"], data["cols"], data.get("runs", []))
+        return jsonify({"map_id": snapshot.map_id, "version": snapshot.version}), 201
 
-        algo_fn = ALGORITHMS.get(algo_name)
-        if algo_fn is None:
-            return jsonify({"error": f"Unknown algorithm '{algo_name}'"}), 400
+    except ValueError as e:
+        return jsonify({"error": str(e)}), 400
+    except KeyError as e:
+        return jsonify({"error": f"Missing required field: {e.args[0]}"}), 400
+    except Exception as e:
+        app.logger.exception("Error creating map")
+        return jsonify({"error": str(e)}), 500
 
-        # Run the algorithm
-        visited_order, shortest_path = algo_fn(grid, start, end)
+@app.route("/api/generate", methods=["POST"])
+def generate_map():
+    """
+    Generate a seeded procedural map and store it like an uploaded one. Expects:
+    {
+        "generator": "random" | "division" | "prim" | "kruskal" | "caves" | "rooms" | "city",
+        "rows": int,
+        "cols": int,
+        "seed": int,      # optional, default 0
+        "params": {...}   # optional generator parameters, e.g. {"density": 0.3}
+    }
+    Returns (201): { "map_id": str, "version": 0, "rows": int, "cols": int, "runs": [...] }
+    """
+    try:
+        data = request.get_json(force=True)
+        return jsonify(_generate_request(data)()), 201
 
-        return jsonify({
-            "visited": visited_order,
-            "path": shortest_path
-        })
+    except ValueError as e:
+        return jsonify({"error": str(e)}), 400
+    except KeyError as e:
+        return jsonify({"error": f"Missing required field: {e.args[0]}"}), 400
+    except Exception as e:
+        app.logger.exception("Error generating map")
+        return jsonify({"error": str(e)}), 500
 
+@app.route("/api/maps/<map_id>", methods=["PATCH"])
+def update_map(map_id):
+    """
+    Apply one edit stroke. Expects:
+    {
+        "base_version": int,                 # version the client last saw
+        "runs": [start, length, value, ...]  # run-length encoded changed cells
+    }
+    Returns { "version": int }; 404 for an unknown map, 409 when base_version is stale.
+    """
+    try:
+        data = request.get_json(force=True)
+        snapshot = map_store.apply(map_id, data["base_version"], data["runs"])
+        return jsonify({"version": snapshot.version})
+
+    except UnknownMapError as e:
+        return jsonify({"error": str(e)}), 404
+    except VersionConflictError as e:
+        return jsonify({"error": str(e)}), 409
+    except ValueError as e:
+        return jsonify({"error": str(e)}), 400
     except KeyError as e:
         return jsonify({"error": f"Missing required field: {e.args[0]}"}), 400
     except Exception as e:
-        app.logger.exception("Error during pathfinding")
+        app.logger.exception("Error updating map")
         return jsonify({"error": str(e)}), 500
 
+@app.route("/api/maps/<map_id>", methods=["PUT"])
+def replace_map(map_id):
+    """
+    Replace the whole map, e.g. after a large edit or a fresh import. Expects:
+    {
+        "base_version": int,
+        "rows": int,
+        "cols": int,
+        "runs": [start, length, value, ...]  # applied to an empty map
+    }
+    Returns (202) { "version": int } for the staged version. Queries keep using
+    the current version until the staged one's derived tables are built; then
+    it goes live in one swap. GET shows "pending_version" meanwhile, and other
+    changes get 409.
+    """
+    try:
+        data = request.get_json(force=True)
+        staged = map_store.replace(map_id, data["base_version"], data["rows"], data["cols"], data["runs"])
+        return jsonify({"version": staged.version}), 202
+
+    except UnknownMapError as e:
+        return jsonify({"error": str(e)}), 404
+    except VersionConflictError as e:
+        return jsonify({"error": str(e)}), 409
+    except ValueError as e:
+        return jsonify({"error": str(e)}), 400
+    except KeyError as e:
+        return jsonify({"error": f"Missing required field: {e.args[0]}"}), 400
+    except Exception as e:
+        app.logger.exception("Error replacing map")
+        return jsonify({"error": str(e)}), 500
+
+@app.route("/api/maps/<map_id>", methods=["GET"])
+def get_map(map_id):
+    """
+    Returns { "rows", "cols", "version", "runs" } for the live version, with
+    the walls as runs, plus "pending_version" while a replacement is prepared.
+    """
+    try:
+        snapshot = map_store.get(map_id)
+        result = {
+            "rows": snapshot.rows,
+            "cols": snapshot.cols,
+            "version": snapshot.version,
+            "runs": encode_runs(snapshot.grid),
+        }
+        pending = map_store.pending_version(map_id)
+        if pending is not None:
+            result["pending_version"] = pending
+        return jsonify(result)
+
+    except UnknownMapError as e:
+        return jsonify({"error": str(e)}), 404
+
+# Admission class of searches run by jobs, whatever their queue priority:
+# background work never takes interactive search slots
+JOB_ADMISSION_CLASS = "batch"
+
+def _admitted_job(data, run, trace_level):
+    # Admission was checked at submission, so a job waits for its slot rather
+    # than failing when it reaches the front of the job queue on a busy server
+    return lambda progress: _run_admitted(data, run.cells, lambda degraded: run(progress), trace_level,
+                                          can_degrade=False, priority=JOB_ADMISSION_CLASS, can_shed=False)
+
+def _solve_job(data):
+    run = _admitted_job(data, _solve_request(data), data.get("trace", "full"))
+    return lambda job: (_encode_json(run(lambda n: job.report(expanded=n))), "application/json")
+
+def _trace_job(data):
+    run = _admitted_job(data, _trace_request(data), "full")
+    return lambda job: (run(lambda n: job.report(expanded=n)), "application/octet-stream")
+
+def _generate_job(data):
+    run = _generate_request(data)
+    return lambda job: (_encode_json(run()), "application/json")
+
+# kind -> (payload parser returning fn(job), default priority, searches under admission control)
+JOB_KINDS = {
+    "solve": (_solve_job, "interactive", True),
+    "trace": (_trace_job, "batch", True),
+    "generate": (_generate_job, "batch", False),
+}
+
+@app.route("/api/jobs", methods=["POST"])
+def submit_job():
+    """
+    Queue work to run in the background. Expects:
+    {
+        "kind": "solve" | "trace" | "generate",
+        "priority": "interactive" | "batch",  # optional; solve defaults to interactive, others to batch
+        ...                                   # the payload of /api/solve, /api/trace or /api/generate
+    }
+    Returns (202) the job status: { "job_id", "kind", "priority", "state", "progress", ... }.
+    Poll GET /api/jobs/<id> or stream GET /api/jobs/<id>/events, then fetch
+    GET /api/jobs/<id>/result. The payload is checked up front; a stored map
+    is read at submission, so later edits do not affect the job.
+
+    Solve and trace jobs search in the batch admission class. Returns 503 with
+    Retry-After when admission control would shed a batch search now, and 429
+    with Retry-After when too many jobs are already queued.
+    """
+    try:
+        data = request.get_json(force=True)
+        kind = data["kind"]
+        if kind not in JOB_KINDS:
+            return jsonify({"error": f"Unknown job kind '{kind}'. Supported: {sorted(JOB_KINDS)}."}), 400
+        prepare, default_priority, admitted = JOB_KINDS[kind]
+        fn = prepare(data)
+        if admitted:
+            admission.check(JOB_ADMISSION_CLASS)
+        job = job_queue.submit(kind, fn, data.get("priority", default_priority))
+        return jsonify(job.status()), 202
+
+    except QueueFullError as e:
+        return _overloaded(e, 429)
+    except OverloadedError as e:
+        return _overloaded(e)
+    except UnknownMapError as e:
+        return jsonify({"error": str(e)}), 404
+    except ValueError as e:
+        return jsonify({"error": str(e)}), 400
+    except KeyError as e:
+        return jsonify({"error": f"Missing required field: {e.args[0]}"}), 400
+    except Exception as e:
+        app.logger.exception("Error submitting job")
+        return jsonify({"error": str(e)}), 500
+
+@app.route("/api/jobs/<job_id>", methods=["GET"])
+def get_job(job_id):
+    """ Returns the job status; "progress" holds {"expanded": n} for running searches. """
+    try:
+        return jsonify(job_queue.get(job_id).status())
+
+    except UnknownJobError as e:
+        return jsonify({"error": str(e)}), 404
+
+@app.route("/api/jobs/<job_id>", methods=["DELETE"])
+def cancel_job(job_id):
+    """ Cancels a queued or running job and returns its status. """
+    try:
+        return jsonify(job_queue.cancel(job_id).status())
+
+    except UnknownJobError as e:
+        return jsonify({"error": str(e)}), 404
+
+@app.route("/api/jobs/<job_id>/events", methods=["GET"])
+def job_events(job_id):
+    """
+    Streams the job status as server-sent events, one "data:" line per change,
+    until it finishes. A comment line is sent every 15 s of silence.
+    """
+    try:
+        job = job_queue.get(job_id)
+    except UnknownJobError as e:
+        return jsonify({"error": str(e)}), 404
+
+    def events():
+        version = -1
+        while True:
+            status = job.wait(version, timeout=15)
+            if status["version"] == version:
+                yield ": keepalive\n\n"
+                continue
+            version = status["version"]
+            yield f"data: {json.dumps(status)}\n\n"
+            if status["state"] in FINISHED_STATES:
+                return
+
+    return Response(events(), mimetype="text/event-stream", headers={"Cache-Control": "no-cache"})
+
+@app.route("/api/jobs/<job_id>/result", methods=["GET"])
+def job_result(job_id):
+    """ The finished job's response body, as its endpoint would have sent it; 409 with the status until then. """
+    try:
+        job = job_queue.get(job_id)
+        if job.state != "done":
+            return jsonify({"error": f"Job is {job.state}.", **job.status()}), 409
+        return Response(job.result, mimetype=job.mimetype)
+
+    except UnknownJobError as e:
+        return jsonify({"error": str(e)}), 404
+
+@app.route("/api/timelines/<timeline_id>", methods=["GET"])
+def get_timeline(timeline_id):
+    """
+    A recorded request timeline as Chrome trace-event JSON ({"traceEvents": [...]}),
+    with "ts" in microseconds from the start of the request; 404 once it has
+    been dropped (the most recent 256 are kept).
+    """
+    timeline = timelines.get(timeline_id)
+    if timeline is None:
+        return jsonify({"error": f"Unknown timeline '{timeline_id}'."}), 404
+    return jsonify(timeline.chrome_trace())
+
+@app.route("/api/metrics", methods=["GET"])
+def metrics():
+    """
+    Returns server load metrics:
+    {
+        "admission": { "slots", "classes": { "interactive": {...}, "batch": {...} }, "us_per_cell" },
+        "coalescing": { "in_flight", "leaders", "shared" },
+        "jobs": { "queued": {...}, "running", "total", "rejected" },
+        "table_cache": { "hits", "misses", "writes", "errors", "files", "bytes", "max_bytes" },
+        "residency": { "budget_bytes", "resident_bytes", "by_kind", "evictions", "maps": [...] }
+    }
+    Each admission class reports queued, running, admitted, degraded, shed,
+    wait_ms_p50, wait_ms_p99, slo_ms and predicted_wait_ms. "table_cache" is
+    null unless PATHFINDER_TABLE_CACHE is set. "residency" lists each stored
+    map's resident artifacts (grid and derived tables) with their estimated
+    bytes, most recently used map first.
+    """
+    return jsonify({
+        "admission": admission.metrics(),
+        "coalescing": coalescer.stats(),
+        "jobs": job_queue.stats(),
+        "table_cache": table_cache.stats() if table_cache is not None else None,
+        "residency": residency.metrics(),
+    })
+
 if __name__ == "__main__":
     # Development server (hot reload, debug mode)
     app.run(host="127.0.0.1", port=5000, debug=True)
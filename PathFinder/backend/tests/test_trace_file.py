@@ -0,0 +1,69 @@
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+
+from algorithms.block_astar import block_astar
+from utils.trace import SearchTrace
+from utils.trace_file import FLAG_HAS_MISSING_COSTS, TraceRecorder, decode_trace, encode_trace
+
+
+def _round_trip(grid, start, end, recorder, path):
+    data = encode_trace(grid, start, end, recorder, path)
+    return data, decode_trace(data)
+
+
+def test_trace_round_trip_keeps_missing_costs():
+    grid = [[0, 0, 0], [0, 1, 0], [0, 0, 0]]
+    recorder = TraceRecorder()
+    recorder.expand((0, 0), 0, 4)
+    recorder.push((0, 1), 1, None)
+    recorder.expand((0, 1), None, 4.5)
+    recorder.push((0, 2), None, None)
+    recorder.expand((0, 2), 2, 4)
+    path = [[0, 0], [0, 1], [0, 2]]
+
+    data, decoded = _round_trip(grid, (0, 0), (0, 2), recorder, path)
+
+    assert data[5] & FLAG_HAS_MISSING_COSTS
+    assert decoded["events"] == [
+        [0, 0, 0, 0, 4],
+        [1, 0, 1, 1, None],
+        [0, 0, 1, None, 4.5],
+        [1, 0, 2, None, None],
+        [0, 0, 2, 2, 4],
+    ]
+    assert decoded["grid"] == grid
+    assert decoded["path"] == path
+
+
+def test_trace_without_missing_costs_has_no_present_column():
+    grid = [[0, 0]]
+    recorder = TraceRecorder()
+    recorder.expand((0, 0), 0, 1)
+    recorder.expand((0, 1), 1, 1)
+
+    data, decoded = _round_trip(grid, (0, 0), (0, 1), recorder, [[0, 0], [0, 1]])
+
+    assert not data[5] & FLAG_HAS_MISSING_COSTS
+    assert [event[3:] for event in decoded["events"]] == [[0, 1], [1, 1]]
+
+
+def test_block_astar_trace_round_trip():
+    grid = [[0] * 10 for _ in range(10)]
+    for r in range(8):
+        grid[r][5] = 1
+    trace = SearchTrace("none", record=True)
+    _, path = block_astar(grid, (0, 0), (0, 9), trace=trace)
+    recorder = trace.recorder
+
+    _, decoded = _round_trip(grid, (0, 0), (0, 9), recorder, path)
+
+    events = decoded["events"]
+    assert [event[0] for event in events] == list(recorder.kinds)
+    assert [event[3] for event in events] == recorder.g
+    assert [event[4] for event in events] == recorder.f
+    # Pushes are single cells, stored with a 1x1 extent
+    assert [event[1:3] + event[5:7] for event in events] == [list(node[:2]) + list(node[2:4] or (1, 1))
+                                                             for node in recorder.nodes]
+    assert decoded["path"] == path
@@ -0,0 +1,236 @@
+"""
+Offline batch solver: many start/end queries on one map, across all cores.
+
+Loads the map once, reads the queries from a scenario file, solves each one
+with every selected `ALGORITHMS` entry in a process pool, and writes one row of
+stats per query and algorithm as CSV or JSON. Derived tables (the visibility
+graph) are prepared once before the workers start, and come from the table
+cache when PATHFINDER_TABLE_CACHE is set (see utils/table_cache.py).
+
+Maps:
+    --map FILE.map      Moving AI benchmark map ('.' and 'G' passable, anything else a wall)
+    --map FILE.grid     a map file as written by the shared map store (memory-mapped)
+    --generator KIND    a procedural map (with --rows, --cols, --seed)
+
+Scenarios:
+    --scenario FILE.scen   Moving AI scenario (x is the column, y the row);
+                           its optimal length is copied to the output
+    --scenario FILE        one query per line: start_row start_col end_row end_col
+                           (spaces or commas; '#' starts a comment)
+    --random N             N random queries between empty cells
+
+Usage (from the backend directory):
+    python -m tools.batch_solve --map arena.map --scenario arena.map.scen \
+        --algorithms astar_8 canonical_astar --out results.csv
+    python -m tools.batch_solve --generator caves --rows 1000 --cols 1000 \
+        --random 5000 --algorithms astar visibility --format json --out results.json
+"""
+
+import argparse
+import csv
+import json
+import math
+import multiprocessing
+import os
+import random
+import sys
+import time
+from concurrent.futures import ProcessPoolExecutor
+
+from algorithms import ALGORITHMS
+from tools.benchmark import random_query
+from utils.derived import ALGORITHM_TABLES
+from utils.map_generators import GENERATORS, generate
+from utils.map_store import MapSnapshot
+from utils.shared_map_store import map_grid_file
+from utils.trace import SearchTrace, TRACE_LEVELS
+
+MOVING_AI_PASSABLE = b".G"
+FIELDS = ["query", "algorithm", "start_row", "start_col", "end_row", "end_col", "found",
+          "path_cells", "path_cost", "optimal", "expanded", "time_ms"]
+
+# Set in the parent before the pool starts; forked workers inherit them
+_snapshot = None
+_trace_level = "full"
+
+
+def load_moving_ai(path):
+    """ Rows of 0/1 bytes from a Moving AI .map file. """
+
+    with open(path, "rb") as f:
+        lines = f.read().splitlines()
+    header = {}
+    for i, line in enumerate(lines):
+        if line.strip() == b"map":
+            body = lines[i + 1:]
+            break
+        key, _, value = line.partition(b" ")
+        header[key.decode()] = value.strip()
+    else:
+        raise ValueError(f"{path} has no 'map' line.")
+    rows, cols = int(header["height"]), int(header["width"])
+    table = bytes(0 if i in MOVING_AI_PASSABLE else 1 for i in range(256))
+    grid = [bytes(line[:cols]).translate(table) for line in body[:rows]]
+    if len(grid) != rows or any(len(row) != cols for row in grid):
+        raise ValueError(f"{path} does not have {rows} rows of {cols} cells.")
+    return grid
+
+
+def load_map(args):
+    if args.map:
+        if args.map.endswith(".grid"):
+            return map_grid_file(args.map)[2]
+        return load_moving_ai(args.map)
+    return generate(args.generator, args.rows, args.cols, args.seed)
+
+
+def load_queries(args, grid):
+    """ [(start, end, optimal or None), ...] """
+
+    if args.random:
+        rng = random.Random(args.seed)
+        return [random_query(rng, grid) + (None,) for _ in range(args.random)]
+
+    queries = []
+    with open(args.scenario) as f:
+        if args.scenario.endswith(".scen"):
+            for line in f:
+                fields = line.split()
+                if len(fields) < 9 or fields[0] == "version":
+                    continue
+                sx, sy, gx, gy = map(int, fields[4:8])
+                queries.append(((sy, sx), (gy, gx), float(fields[8])))
+        else:
+            for line in f:
+                fields = line.split("#")[0].replace(",", " ").split()
+                if fields:
+                    sr, sc, er, ec = map(int, fields)
+                    queries.append(((sr, sc), (er, ec), None))
+    return queries
+
+
+def prepare(grid, algorithms):
+    """ Wrap the map in a snapshot and build (or load) the tables the algorithms use. """
+
+    snapshot = MapSnapshot("batch", len(grid), len(grid[0]), 0, grid)
+    for name in algorithms:
+        if name in ALGORITHM_TABLES:
+            snapshot.table(ALGORITHM_TABLES[name][0])
+    return snapshot
+
+
+def _init_worker(args):
+    # Only needed where workers are not forked (spawn): load and prepare again
+    global _snapshot, _trace_level
+    if _snapshot is None:
+        _snapshot = prepare(load_map(args), args.algorithms)
+        _trace_level = args.trace
+
+
+def path_cost(path):
+    return sum(math.dist(a, b) for a, b in zip(path, path[1:]))
+
+
+def solve_one(task):
+    index, name, start, end, optimal = task
+    fn = ALGORITHMS[name]
+    kwargs = {}
+    if name in ALGORITHM_TABLES:
+        table, keyword = ALGORITHM_TABLES[name]
+        kwargs[keyword] = _snapshot.table(table)
+    trace = SearchTrace(_trace_level)
+
+    t0 = time.perf_counter()
+    visited, path = fn(_snapshot.grid, start, end, trace=trace, **kwargs)
+    elapsed = time.perf_counter() - t0
+    path = path or []
+    return {
+        "query": index,
+        "algorithm": name,
+        "start_row": start[0], "start_col": start[1],
+        "end_row": end[0], "end_col": end[1],
+        "found": bool(path),
+        "path_cells": len(path),
+        "path_cost": round(path_cost(path), 4),
+        "optimal": optimal,
+        # Only a full trace lists every expansion
+        "expanded": len(visited) if _trace_level == "full" else None,
+        "time_ms": round(1000.0 * elapsed, 3),
+    }
+
+
+def write_results(results, out, fmt):
+    if fmt == "json":
+        json.dump(results, out, indent=1)
+        out.write("\n")
+        return
+    writer = csv.DictWriter(out, fieldnames=FIELDS)
+    writer.writeheader()
+    writer.writerows(results)
+
+
+def summarize(results, wall):
+    print(f"{'algorithm':<20}{'queries':>9}{'solved':>9}{'mean ms':>10}{'p50 ms':>10}{'p99 ms':>10}",
+          file=sys.stderr)
+    for name in dict.fromkeys(r["algorithm"] for r in results):
+        times = sorted(r["time_ms"] for r in results if r["algorithm"] == name)
+        solved = sum(r["found"] for r in results if r["algorithm"] == name)
+        p50 = times[len(times) // 2]
+        p99 = times[min(len(times) - 1, int(0.99 * len(times)))]
+        print(f"{name:<20}{len(times):>9}{solved:>9}{sum(times) / len(times):>10.2f}{p50:>10.2f}{p99:>10.2f}",
+              file=sys.stderr)
+    print(f"{len(results)} solves in {wall:.2f} s ({len(results) / wall:.0f}/s)", file=sys.stderr)
+
+
+def main():
+    global _snapshot, _trace_level
+
+    parser = argparse.ArgumentParser(description="Solve a scenario file of queries on one map.")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--map", help="Moving AI .map file, or a .grid map file")
+    source.add_argument("--generator", choices=sorted(GENERATORS), help="generate the map instead")
+    parser.add_argument("--rows", type=int, default=512)
+    parser.add_argument("--cols", type=int, default=512)
+    queries = parser.add_mutually_exclusive_group(required=True)
+    queries.add_argument("--scenario", help="Moving AI .scen file, or one 'sr sc er ec' query per line")
+    queries.add_argument("--random", type=int, metavar="N", help="N random queries")
+    parser.add_argument("--seed", type=int, default=0, help="seed for --generator and --random")
+    parser.add_argument("--algorithms", nargs="+", default=["astar"], choices=sorted(ALGORITHMS))
+    parser.add_argument("--trace", default="full", choices=TRACE_LEVELS,
+                        help="trace level per run ('full' is needed for the expanded column)")
+    parser.add_argument("--workers", type=int, default=os.cpu_count() or 1)
+    parser.add_argument("--format", choices=("csv", "json"),
+                        help="output format (default: from --out's extension, else csv)")
+    parser.add_argument("--out", help="output file (default: stdout)")
+    args = parser.parse_args()
+
+    grid = load_map(args)
+    tasks = [(i, name, start, end, optimal)
+             for i, (start, end, optimal) in enumerate(load_queries(args, grid))
+             for name in args.algorithms]
+    _snapshot = prepare(grid, args.algorithms)
+    _trace_level = args.trace
+
+    t0 = time.perf_counter()
+    if args.workers > 1 and len(tasks) > 1:
+        # Forked workers share the loaded map and its tables copy-on-write
+        method = "fork" if "fork" in multiprocessing.get_all_start_methods() else None
+        with ProcessPoolExecutor(args.workers, mp_context=multiprocessing.get_context(method),
+                                 initializer=_init_worker, initargs=(args,)) as pool:
+            results = list(pool.map(solve_one, tasks, chunksize=max(1, len(tasks) // (args.workers * 8))))
+    else:
+        results = [solve_one(task) for task in tasks]
+    wall = time.perf_counter() - t0
+
+    fmt = args.format or ("json" if args.out and args.out.endswith(".json") else "csv")
+    if args.out:
+        with open(args.out, "w", newline="") as out:
+            write_results(results, out, fmt)
+    else:
+        write_results(results, sys.stdout, fmt)
+    if results:
+        summarize(results, wall)
+
+
+if __name__ == "__main__":
+    main()
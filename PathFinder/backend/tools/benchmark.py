@@ -0,0 +1,95 @@
+"""
+Benchmark harness for the entries in `algorithms.ALGORITHMS`.
+
+Runs every selected algorithm over the same seeded random grid, or a map from
+one of the procedural generators in `utils.map_generators`, and reports mean
+wall time, mean expansions (length of visited_order) and path length.
+
+Usage (from the backend directory):
+    python -m tools.benchmark --size 200 --density 0.25 --queries 20 \
+        --algorithms dijkstra_8 canonical_dijkstra astar_8 canonical_astar
+    python -m tools.benchmark --size 1000 --generator caves --algorithms astar block_astar
+"""
+
+import argparse
+import random
+import time
+
+from algorithms import ALGORITHMS
+from utils.map_generators import GENERATORS, generate
+from utils.trace import SearchTrace, TRACE_LEVELS
+
+# Generators that take a density parameter from --density
+DENSITY_GENERATORS = ("random", "caves")
+
+
+def random_grid(rng, rows, cols, density):
+    return [[1 if rng.random() < density else 0 for _ in range(cols)] for _ in range(rows)]
+
+
+def random_query(rng, grid):
+    rows, cols = len(grid), len(grid[0])
+    while True:
+        start = (rng.randrange(rows), rng.randrange(cols))
+        end = (rng.randrange(rows), rng.randrange(cols))
+        if grid[start[0]][start[1]] == 0 and grid[end[0]][end[1]] == 0 and start != end:
+            return start, end
+
+
+def run(algorithms, cases, trace_level="full"):
+    """ Return {name: {"time_ms", "expanded", "path_len", "solved"}} averaged over `cases`. """
+
+    results = {}
+    for name in algorithms:
+        fn = ALGORITHMS[name]
+        total_time = total_expanded = total_path = solved = 0
+        for grid, start, end in cases:
+            t0 = time.perf_counter()
+            visited, path = fn(grid, start, end, trace=SearchTrace(trace_level))
+            total_time += time.perf_counter() - t0
+            total_expanded += len(visited)
+            total_path += len(path)
+            solved += bool(path)
+        n = len(cases)
+        results[name] = {
+            "time_ms": 1000.0 * total_time / n,
+            "expanded": total_expanded / n,
+            "path_len": total_path / n,
+            "solved": solved,
+        }
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark pathfinding algorithms on random grids.")
+    parser.add_argument("--size", type=int, default=100, help="grid side length")
+    parser.add_argument("--density", type=float, default=None,
+                        help="wall probability per cell (default 0.25), or the generator's density")
+    parser.add_argument("--generator", choices=sorted(GENERATORS),
+                        help="build the map with this procedural generator instead")
+    parser.add_argument("--queries", type=int, default=10, help="number of random start/end pairs")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--trace", default="full", choices=TRACE_LEVELS,
+                        help="exploration trace level passed to every run")
+    parser.add_argument("--algorithms", nargs="+", default=sorted(ALGORITHMS),
+                        choices=sorted(ALGORITHMS))
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    if args.generator:
+        params = {}
+        if args.density is not None and args.generator in DENSITY_GENERATORS:
+            params["density"] = args.density
+        grid = generate(args.generator, args.size, args.size, args.seed, **params)
+    else:
+        grid = random_grid(rng, args.size, args.size, 0.25 if args.density is None else args.density)
+    cases = [(grid,) + random_query(rng, grid) for _ in range(args.queries)]
+
+    results = run(args.algorithms, cases, args.trace)
+    print(f"{'algorithm':<20}{'time (ms)':>12}{'expanded':>12}{'path len':>12}{'solved':>8}")
+    for name, r in results.items():
+        print(f"{name:<20}{r['time_ms']:>12.2f}{r['expanded']:>12.1f}{r['path_len']:>12.1f}{r['solved']:>8}")
+
+
+if __name__ == "__main__":
+    main()
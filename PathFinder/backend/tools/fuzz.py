@@ -0,0 +1,481 @@
+"""
+Differential fuzzer for the search engines.
+
+Generates random grids and queries, runs each engine on them and checks the
+result against a reference:
+
+    path       starts and ends at the endpoints, stays on free cells, takes only
+               legal steps for the engine's connectivity and never revisits a cell
+    found      a path is returned exactly when the reference finds one
+    cost       exact engines match the reference cost (Dijkstra, 4- or
+               8-connected); weighted A* stays within its weight of it
+    same       engines that only change how the work is done return what they
+               stand in for: specialized kernels (algorithms/kernels.py) and
+               buffer grids the same output as the generic loops on nested
+               lists, and shared, cached or patched visibility graphs the same
+               corners and edges as a fresh build
+    visited    full-trace entries are in bounds and on free cells, without
+               repeats where the search closes nodes
+    trace      trace "none" returns the same path as "full", and "sampled"
+               returns every k-th entry of the full visited order
+
+The maps in REGRESSIONS, cases that once failed, run before the random ones.
+A failing case is shrunk before it is reported. The shrinker crops rows and
+columns and clears walls for as long as the same check still fails. Each
+failure is printed as a small map and, with --out, written as JSON that
+--replay runs again.
+
+Usage (from the backend directory):
+    python -m tools.fuzz --cases 500
+    python -m tools.fuzz --cases 2000 --max-size 40 --engines astar jps --out fuzz-failures
+    python -m tools.fuzz --replay fuzz-failures/jps-cost-0.json
+"""
+
+import argparse
+import itertools
+import json
+import os
+import random
+import signal
+import sys
+import time
+
+from algorithms import ALGORITHMS, solve
+from algorithms import kernels
+from algorithms.astar import astar
+from algorithms.canonical import move_cost
+from algorithms.dijkstra import dijkstra
+from algorithms.visibility_graph import VisibilityGraph, derive_visibility_graph, get_visibility_graph
+from utils.map_generators import GENERATORS, generate
+from utils.trace import SearchTrace
+
+# Heuristic weight of the weighted A* runs admission control degrades to (see app.py)
+WEIGHT = 2
+SAMPLE_EVERY = 3
+MAX_SHRINK_ROUNDS = 20
+
+# Shrunk maps of past failures (render() format), checked before the random cases
+REGRESSIONS = [
+    # Any-angle legs whose rasterizations overlapped: the joined path stepped
+    # from (3, 5) to (2, 5) and back
+    ["E..#....",
+     "..#...#.",
+     ".#......",
+     "..#.....",
+     "...#.#..",
+     "..#...#.",
+     "....##..",
+     "....#..S"],
+]
+
+
+class Engine:
+    """
+    One way of answering a query. `claim` is what it promises about its path:
+    "exact" (reference cost), "bounded" (at most `weight` times it), "valid"
+    (any path) or "any-angle" (4-connected cells along straight legs). With
+    `same_as`, its output must equal that engine's output; with `graph_of`, it
+    searches that visibility graph, which must equal a fresh build.
+    """
+
+    def __init__(self, run, claim="exact", diagonal=False, weight=1, same_as=None, graph_of=None,
+                 unique=True, default=True):
+        self.run = run
+        self.graph_of = graph_of
+        self.claim = claim
+        self.diagonal = diagonal
+        self.weight = weight
+        self.same_as = same_as
+        self.unique = unique
+        self.default = default
+
+
+def _algorithm(name, **kwargs):
+    fn = ALGORITHMS[name]
+    return lambda grid, start, end, trace: fn(grid, start, end, trace=trace, **kwargs)
+
+
+def _function(fn, **kwargs):
+    return lambda grid, start, end, trace: fn(grid, start, end, trace=trace, **kwargs)
+
+
+def _buffered(name):
+    # The cells as one flat byte buffer, read in place by solve()
+    def run(grid, start, end, trace):
+        flat = bytes(cell for row in grid for cell in row)
+        result = solve(flat, start, end, name, shape=(len(grid), len(grid[0])), trace=trace)
+        width = result.visited_width
+        visited = [list(result.visited[i:i + width]) for i in range(0, len(result.visited), width)]
+        path = [list(result.path[i:i + 2]) for i in range(0, len(result.path), 2)]
+        return visited, path
+    return run
+
+
+def _visibility(graph_of):
+    fn = ALGORITHMS["visibility"]
+    run = lambda grid, start, end, trace: fn(grid, start, end, graph=graph_of(grid), trace=trace)
+    return Engine(run, claim="any-angle", graph_of=graph_of)
+
+
+def graph_content(graph):
+    """ A visibility graph's walls, corners and edges, independent of insertion order. """
+
+    return graph.packed, {corner: sorted((other, round(d, 9)) for other, d in links.items())
+                          for corner, links in graph.edges.items()}
+
+
+def _codec_graph(grid):
+    # Through the table cache's on-disk layout and back
+    return VisibilityGraph.from_sections(grid, VisibilityGraph(grid).to_sections())
+
+
+def _patched_graph(grid):
+    # Built for a copy with a few cells flipped, then patched back to `grid`
+    rng = random.Random(len(grid) * 7919 + len(grid[0]))
+    edited = [list(row) for row in grid]
+    for _ in range(3):
+        r, c = rng.randrange(len(grid)), rng.randrange(len(grid[0]))
+        edited[r][c] ^= 1
+    return derive_visibility_graph(grid, VisibilityGraph(edited))
+
+
+ENGINES = {
+    "bfs": Engine(_algorithm("bfs")),
+    "dfs": Engine(_algorithm("dfs"), claim="valid"),
+    "dijkstra": Engine(_algorithm("dijkstra"), same_as="generic_dijkstra"),
+    "generic_dijkstra": Engine(_function(dijkstra)),
+    "astar": Engine(_algorithm("astar"), same_as="generic_astar"),
+    "generic_astar": Engine(_function(astar)),
+    "bidirectional": Engine(_algorithm("bidirectional")),
+    "gbfs": Engine(_algorithm("gbfs"), claim="valid"),
+    "jps": Engine(_algorithm("jps")),
+    # Can stop at its expansion limit (SearchLimitError) on larger open grids:
+    # select it with a small --max-size
+    "rbfs": Engine(_algorithm("rbfs"), unique=False, default=False),
+    "block_astar": Engine(_algorithm("block_astar")),
+    "block_astar_2": Engine(_algorithm("block_astar", block_size=2)),
+    "block_astar_8": Engine(_algorithm("block_astar", block_size=8)),
+    "weighted_astar": Engine(_function(kernels.astar, weight=WEIGHT), claim="bounded", weight=WEIGHT,
+                             same_as="generic_weighted_astar"),
+    "generic_weighted_astar": Engine(_function(astar, weight=WEIGHT), claim="bounded", weight=WEIGHT),
+    "dijkstra_8": Engine(_algorithm("dijkstra_8"), diagonal=True, same_as="generic_dijkstra_8"),
+    "generic_dijkstra_8": Engine(_function(dijkstra, diagonal=True), diagonal=True),
+    "astar_8": Engine(_algorithm("astar_8"), diagonal=True, same_as="generic_astar_8"),
+    "generic_astar_8": Engine(_function(astar, diagonal=True), diagonal=True),
+    "canonical_dijkstra": Engine(_algorithm("canonical_dijkstra"), diagonal=True),
+    "canonical_astar": Engine(_algorithm("canonical_astar"), diagonal=True),
+    "weighted_astar_8": Engine(_function(kernels.astar, diagonal=True, weight=WEIGHT), claim="bounded",
+                               diagonal=True, weight=WEIGHT, same_as="generic_weighted_astar_8"),
+    "generic_weighted_astar_8": Engine(_function(astar, diagonal=True, weight=WEIGHT), claim="bounded",
+                                       diagonal=True, weight=WEIGHT),
+    "visibility": _visibility(VisibilityGraph),
+    # The per-shape cache that inline grids use, patched from one case to the next
+    "visibility_shared": _visibility(get_visibility_graph),
+    "visibility_codec": _visibility(_codec_graph),
+    "visibility_patched": _visibility(_patched_graph),
+    "buffer_astar": Engine(_buffered("astar"), same_as="astar"),
+    "buffer_astar_8": Engine(_buffered("astar_8"), diagonal=True, same_as="astar_8"),
+    "buffer_block_astar": Engine(_buffered("block_astar"), same_as="block_astar"),
+    "buffer_visibility": Engine(_buffered("visibility"), claim="any-angle", same_as="visibility_shared"),
+}
+
+REFERENCES = {False: _function(dijkstra), True: _function(dijkstra, diagonal=True)}
+
+
+class EngineTimeout(Exception):
+    pass
+
+
+def _on_alarm(signum, frame):
+    raise EngineTimeout()
+
+
+def run_limited(run, grid, start, end, trace, timeout):
+    """ run(...) with a wall-clock limit (SIGALRM, so main thread only). """
+
+    if not timeout:
+        return run(grid, start, end, trace)
+    previous = signal.signal(signal.SIGALRM, _on_alarm)
+    signal.setitimer(signal.ITIMER_REAL, timeout)
+    try:
+        return run(grid, start, end, trace)
+    finally:
+        signal.setitimer(signal.ITIMER_REAL, 0)
+        signal.signal(signal.SIGALRM, previous)
+
+
+def path_cost(path, diagonal):
+    if not diagonal:
+        return len(path) - 1
+    return sum(move_cost(b[0] - a[0], b[1] - a[1]) for a, b in zip(path, path[1:]))
+
+
+def _free(grid, r, c):
+    return 0 <= r < len(grid) and 0 <= c < len(grid[0]) and grid[r][c] == 0
+
+
+def path_problem(grid, start, end, path, diagonal):
+    """ Why `path` is not a legal path from start to end, or None. """
+
+    if [list(path[0]), list(path[-1])] != [list(start), list(end)]:
+        return f"runs {tuple(path[0])} -> {tuple(path[-1])}"
+    seen = set()
+    for i, (r, c) in enumerate(path):
+        if not _free(grid, r, c):
+            return f"step {i} is on a wall or off the grid at {(r, c)}"
+        if (r, c) in seen:
+            return f"revisits {(r, c)} at step {i}"
+        seen.add((r, c))
+        if i == 0:
+            continue
+        dr, dc = r - path[i - 1][0], c - path[i - 1][1]
+        if diagonal and dr and dc:
+            if abs(dr) != 1 or abs(dc) != 1 or not (_free(grid, r - dr, c) and _free(grid, r, c - dc)):
+                return f"illegal diagonal step {i} into {(r, c)}"
+        elif abs(dr) + abs(dc) != 1:
+            return f"illegal step {i} from {tuple(path[i - 1])} to {(r, c)}"
+    return None
+
+
+def visited_problem(grid, visited, unique):
+    seen = set()
+    for i, entry in enumerate(visited):
+        r, c = entry[0], entry[1]
+        h, w = (entry[2], entry[3]) if len(entry) == 4 else (1, 1)
+        if not (0 <= r and 0 <= c and r + h <= len(grid) and c + w <= len(grid[0])):
+            return f"entry {i} {list(entry)} is off the grid"
+        if len(entry) == 2 and grid[r][c] != 0:
+            return f"entry {i} {list(entry)} is a wall"
+        if unique and tuple(entry) in seen:
+            return f"entry {i} {list(entry)} repeats"
+        seen.add(tuple(entry))
+    return None
+
+
+def check(engine_name, grid, start, end, timeout, outputs=None):
+    """
+    Run one engine on one case; return (check, message) for the first broken
+    invariant, or None. `outputs` caches engine and reference results per case.
+    """
+
+    outputs = {} if outputs is None else outputs
+    engine = ENGINES[engine_name]
+
+    def output(name, level="full"):
+        key = (name, level)
+        if key not in outputs:
+            trace = SearchTrace(level, SAMPLE_EVERY)
+            run = REFERENCES[name[1]] if isinstance(name, tuple) else ENGINES[name].run
+            visited, path = run_limited(run, grid, start, end, trace, timeout)
+            outputs[key] = (visited, path or [])
+        return outputs[key]
+
+    try:
+        visited, path = output(engine_name)
+        _, reference = output(("reference", engine.diagonal))
+        if engine.same_as:
+            expected = output(engine.same_as)
+            if (visited, path) != expected:
+                part = "path" if path != expected[1] else "visited order"
+                return "same", f"{part} differs from {engine.same_as}"
+        if engine.graph_of is not None and engine.graph_of is not VisibilityGraph:
+            if graph_content(engine.graph_of(grid)) != graph_content(VisibilityGraph(grid)):
+                return "same", "visibility graph differs from a fresh build"
+
+        if bool(path) != bool(reference):
+            return "found", "found a path where there is none" if path else "missed a path the reference found"
+        if path:
+            problem = path_problem(grid, start, end, path, engine.diagonal and engine.claim != "any-angle")
+            if problem:
+                return "path", problem
+            cost, best = path_cost(path, engine.diagonal), path_cost(reference, engine.diagonal)
+            if engine.claim == "exact" and cost != best:
+                return "cost", f"cost {cost}, shortest {best}"
+            if engine.claim == "bounded" and cost > engine.weight * best:
+                return "cost", f"cost {cost} exceeds {engine.weight} x shortest {best}"
+
+        problem = visited_problem(grid, visited, engine.unique)
+        if problem:
+            return "visited", problem
+
+        if output(engine_name, "none")[1] != path:
+            return "trace", "trace 'none' returns a different path"
+        sampled = output(engine_name, "sampled")
+        if sampled[1] != path or sampled[0] != visited[::SAMPLE_EVERY]:
+            return "trace", f"trace 'sampled' is not every {SAMPLE_EVERY}th full-trace entry"
+    except EngineTimeout:
+        return "timeout", f"took longer than {timeout} s"
+    except Exception as e:
+        return "crash", f"{type(e).__name__}: {e}"
+    return None
+
+
+def random_case(rng, max_size):
+    """ (grid, start, end) on a random or generated map; endpoints are always free. """
+
+    rows, cols = rng.randint(1, max_size), rng.randint(1, max_size)
+    grid = None
+    if rng.random() < 0.3 and min(rows, cols) >= 5:
+        kind = rng.choice(sorted(GENERATORS))
+        try:
+            grid = [list(row) for row in generate(kind, rows, cols, rng.randrange(2 ** 31))]
+        except ValueError:
+            pass
+    if grid is None:
+        density = rng.uniform(0.0, 0.5)
+        grid = [[int(rng.random() < density) for _ in range(cols)] for _ in range(rows)]
+    free = [(r, c) for r in range(rows) for c in range(cols) if grid[r][c] == 0]
+    if not free:
+        grid[0][0] = 0
+        free = [(0, 0)]
+    start = rng.choice(free)
+    end = start if rng.random() < 0.05 else rng.choice(free)
+    return grid, start, end
+
+
+def shrink(engine_name, failed, grid, start, end, timeout):
+    """ The smallest case found by cropping and clearing walls that still fails `failed`. """
+
+    def fails(g, s, e):
+        result = check(engine_name, g, s, e, timeout)
+        return result is not None and result[0] == failed
+
+    for _ in range(MAX_SHRINK_ROUNDS):
+        changed = False
+        # Drop rows, then columns (as rows of the transposed case), that hold neither endpoint
+        for axis in (0, 1):
+            case = (grid, start, end) if axis == 0 else _transposed((grid, start, end))
+            for i in range(len(case[0]) - 1, -1, -1):
+                if len(case[0]) > 1 and i not in (case[1][0], case[2][0]):
+                    candidate = _without_row(case, i)
+                    if fails(*(candidate if axis == 0 else _transposed(candidate))):
+                        case = candidate
+                        changed = True
+            grid, start, end = case if axis == 0 else _transposed(case)
+        # Clear walls one at a time
+        for r in range(len(grid)):
+            for c in range(len(grid[0])):
+                if grid[r][c]:
+                    grid[r][c] = 0
+                    if fails(grid, start, end):
+                        changed = True
+                    else:
+                        grid[r][c] = 1
+        if not changed:
+            break
+    return grid, start, end
+
+
+def _without_row(case, i):
+    grid, start, end = case
+    return grid[:i] + grid[i + 1:], (start[0] - (start[0] > i), start[1]), (end[0] - (end[0] > i), end[1])
+
+
+def _transpose(grid):
+    return [list(col) for col in zip(*grid)]
+
+
+def _transposed(case):
+    grid, start, end = case
+    return _transpose(grid), start[::-1], end[::-1]
+
+
+def render(grid, start, end):
+    lines = []
+    for r, row in enumerate(grid):
+        line = ["#" if cell else "." for cell in row]
+        line[start[1]] = "S" if r == start[0] else line[start[1]]
+        if r == end[0]:
+            line[end[1]] = "E" if (r, end[1]) != tuple(start) else "*"
+        lines.append("".join(line))
+    return lines
+
+
+def parse_map(lines):
+    """ render() output back to (grid, start, end). """
+
+    grid, start, end = [], None, None
+    for r, line in enumerate(lines):
+        grid.append([1 if ch == "#" else 0 for ch in line])
+        for c, ch in enumerate(line):
+            if ch in "S*":
+                start = (r, c)
+            if ch in "E*":
+                end = (r, c)
+    return grid, start, end
+
+
+def report(failure):
+    print(f"\n{failure['engine']}: {failure['check']}: {failure['message']}"
+          f" (shrunk from {failure['original_size'][0]}x{failure['original_size'][1]})")
+    for line in failure["map"]:
+        print("    " + line)
+
+
+def replay(path, timeout):
+    with open(path) as f:
+        failure = json.load(f)
+    grid, start, end = parse_map(failure["map"])
+    result = check(failure["engine"], grid, start, end, timeout)
+    print(f"{failure['engine']}: " + (f"{result[0]}: {result[1]}" if result else "passes now"))
+    return result is None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Differentially fuzz the search engines against Dijkstra.")
+    parser.add_argument("--cases", type=int, default=300)
+    parser.add_argument("--max-size", type=int, default=24, help="largest grid side")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--engines", nargs="+", choices=sorted(ENGINES),
+                        default=[name for name, engine in ENGINES.items() if engine.default],
+                        help="engines to check (default: all but rbfs)")
+    parser.add_argument("--timeout", type=float, default=5.0, help="seconds per engine run (0: none)")
+    parser.add_argument("--out", help="directory for shrunk failing cases as JSON")
+    parser.add_argument("--replay", help="rerun a case written by --out")
+    args = parser.parse_args()
+
+    if args.replay:
+        sys.exit(0 if replay(args.replay, args.timeout) else 1)
+
+    rng = random.Random(args.seed)
+    failures = {}   # (engine, check) -> first shrunk failure
+    counts = {name: 0 for name in args.engines}
+    t0 = time.perf_counter()
+    cases = itertools.chain((parse_map(lines) for lines in REGRESSIONS),
+                            (random_case(rng, args.max_size) for _ in range(args.cases)))
+    for i, (grid, start, end) in enumerate(cases):
+        outputs = {}
+        for name in args.engines:
+            if any(key[0] == name for key in failures):
+                continue   # one shrunk example per engine is enough
+            result = check(name, grid, start, end, args.timeout, outputs)
+            if result is None:
+                continue
+            counts[name] += 1
+            small = shrink(name, result[0], [list(row) for row in grid], start, end, args.timeout)
+            again = check(name, *small, args.timeout)
+            if again is None or again[0] != result[0]:
+                # Depends on more than the case (e.g. state left by earlier cases): keep it whole
+                small, again = (grid, start, end), result
+            message = again[1]
+            failure = {"engine": name, "check": result[0], "message": message, "case": i,
+                       "seed": args.seed, "original_size": [len(grid), len(grid[0])],
+                       "map": render(*small)}
+            failures[(name, result[0])] = failure
+            report(failure)
+            if args.out:
+                os.makedirs(args.out, exist_ok=True)
+                with open(os.path.join(args.out, f"{name}-{result[0]}-{i}.json"), "w") as f:
+                    json.dump(failure, f, indent=1)
+
+    elapsed = time.perf_counter() - t0
+    print(f"\n{len(REGRESSIONS)} regression and {args.cases} random cases, "
+          f"{len(args.engines)} engines in {elapsed:.1f} s")
+    for name in args.engines:
+        status = "FAIL" if counts[name] else "ok"
+        print(f"  {name:<26}{status}")
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
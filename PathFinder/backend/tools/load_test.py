@@ -0,0 +1,254 @@
+"""
+Load generator for a running backend's /api/solve.
+
+Replays a mix of grid sizes, algorithms and trace levels against the server,
+either at a fixed rate (--qps, open loop) or with a fixed number of requests
+in flight (--concurrency, closed loop). It reports latency percentiles
+(p50/p90/p99/p999), throughput and error rates per mix entry and overall.
+
+In --qps mode each request's latency is measured from the moment it was due,
+not from when a sender thread got to it. A server that falls behind therefore
+shows up in the tail instead of quietly lowering the offered rate.
+
+Reports can be saved (--save) and compared against a saved baseline
+(--baseline). The comparison exits with status 1 when p99 latency or
+throughput is worse than the baseline by more than --tolerance (relative), or
+the error rate by more than --error-tolerance (absolute).
+
+Usage (from the backend directory, with the server running):
+    python -m tools.load_test --qps 20 --duration 30 --save baseline.json
+    python -m tools.load_test --qps 20 --duration 30 --baseline baseline.json
+    python -m tools.load_test --concurrency 8 --mix 100:astar:none 200:visibility:full
+"""
+
+import argparse
+import itertools
+import json
+import random
+import sys
+import threading
+import time
+import urllib.error
+import urllib.request
+from concurrent.futures import ThreadPoolExecutor
+
+from tools.benchmark import random_grid, random_query
+
+DEFAULT_MIX = ["50:astar:full", "100:astar:none", "100:bfs:sampled", "200:dijkstra_8:none",
+               "200:visibility:none"]
+PERCENTILES = (("p50", 0.50), ("p90", 0.90), ("p99", 0.99), ("p999", 0.999))
+DENSITY = 0.25
+MAX_SENDERS = 512
+
+
+def parse_mix(entries):
+    """ ["size:algorithm:trace[:weight]", ...] -> [(label, size, algorithm, trace, weight), ...] """
+
+    mix = []
+    for entry in entries:
+        parts = entry.split(":")
+        if len(parts) not in (3, 4):
+            raise ValueError(f"Bad mix entry '{entry}'; expected size:algorithm:trace[:weight].")
+        weight = float(parts[3]) if len(parts) == 4 else 1.0
+        mix.append((":".join(parts[:3]), int(parts[0]), parts[1], parts[2], weight))
+    return mix
+
+
+def build_bodies(mix, distinct, seed):
+    """ `distinct` pre-encoded request bodies per mix entry, on one seeded grid per size. """
+
+    rng = random.Random(seed)
+    grids = {}
+    bodies = {}
+    for label, size, algorithm, trace, _ in mix:
+        grid = grids.setdefault(size, random_grid(rng, size, size, DENSITY))
+        bodies[label] = []
+        for _ in range(distinct):
+            start, end = random_query(rng, grid)
+            bodies[label].append(json.dumps({
+                "grid": grid, "start": start, "end": end, "algorithm": algorithm, "trace": trace,
+            }).encode())
+    return bodies
+
+
+def send(url, body, timeout):
+    """ POST one request; returns (outcome, degraded) with outcome "ok", an HTTP status, or "error". """
+
+    req = urllib.request.Request(url, data=body, headers={"Content-Type": "application/json"})
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as resp:
+            data = resp.read()
+        return "ok", b'"degraded": true' in data or b'"degraded":true' in data
+    except urllib.error.HTTPError as e:
+        e.read()
+        return str(e.code), False
+    except (urllib.error.URLError, OSError):
+        return "error", False
+
+
+class Recorder:
+    """ Latencies and outcomes per mix label, filled in by the sender threads. """
+
+    def __init__(self):
+        self.samples = {}
+        self._lock = threading.Lock()
+
+    def add(self, label, latency_ms, outcome, degraded):
+        with self._lock:
+            self.samples.setdefault(label, []).append((latency_ms, outcome, degraded))
+
+
+def _percentile(ordered, q):
+    if not ordered:
+        return 0.0
+    return ordered[min(len(ordered) - 1, int(q * len(ordered)))]
+
+
+def summarize(samples, elapsed):
+    """ Stats for one list of (latency ms, outcome, degraded) samples. """
+
+    ok = sorted(latency for latency, outcome, _ in samples if outcome == "ok")
+    outcomes = {}
+    for _, outcome, _ in samples:
+        if outcome != "ok":
+            outcomes[outcome] = outcomes.get(outcome, 0) + 1
+    stats = {
+        "requests": len(samples),
+        "ok": len(ok),
+        "throughput_rps": len(ok) / elapsed if elapsed else 0.0,
+        "error_rate": (len(samples) - len(ok)) / len(samples) if samples else 0.0,
+        "errors": outcomes,
+        "degraded": sum(degraded for _, _, degraded in samples),
+        "mean_ms": sum(ok) / len(ok) if ok else 0.0,
+    }
+    for name, q in PERCENTILES:
+        stats[f"{name}_ms"] = _percentile(ok, q)
+    return stats
+
+
+def run_load(url, mix, bodies, qps, concurrency, duration, timeout, seed):
+    rng = random.Random(seed + 1)
+    labels = [entry[0] for entry in mix]
+    weights = [entry[4] for entry in mix]
+    counters = {label: itertools.count() for label in labels}
+    recorder = Recorder()
+
+    def one(label, due):
+        body = bodies[label][next(counters[label]) % len(bodies[label])]
+        outcome, degraded = send(url, body, timeout)
+        recorder.add(label, 1000.0 * (time.perf_counter() - due), outcome, degraded)
+
+    started = time.perf_counter()
+    deadline = started + duration
+    if qps:
+        # Open loop: one request due every 1/qps seconds, whatever the server does
+        with ThreadPoolExecutor(max_workers=concurrency) as pool:
+            for i in itertools.count():
+                due = started + i / qps
+                if due >= deadline:
+                    break
+                time.sleep(max(0.0, due - time.perf_counter()))
+                pool.submit(one, rng.choices(labels, weights)[0], due)
+    else:
+        # Closed loop: each sender starts its next request when the last one returns
+        choose_lock = threading.Lock()
+
+        def sender():
+            while time.perf_counter() < deadline:
+                with choose_lock:
+                    label = rng.choices(labels, weights)[0]
+                one(label, time.perf_counter())
+
+        threads = [threading.Thread(target=sender) for _ in range(concurrency)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+    elapsed = time.perf_counter() - started
+
+    report = {"overall": summarize([s for samples in recorder.samples.values() for s in samples], elapsed),
+              "mix": {label: summarize(samples, elapsed) for label, samples in recorder.samples.items()}}
+    return report
+
+
+def print_report(report):
+    print(f"{'mix':<28}{'reqs':>7}{'rps':>8}{'err %':>7}{'p50':>9}{'p90':>9}{'p99':>9}{'p999':>9}")
+    rows = list(report["mix"].items()) + [("overall", report["overall"])]
+    for label, s in rows:
+        print(f"{label:<28}{s['requests']:>7}{s['throughput_rps']:>8.1f}{100 * s['error_rate']:>7.1f}"
+              f"{s['p50_ms']:>9.1f}{s['p90_ms']:>9.1f}{s['p99_ms']:>9.1f}{s['p999_ms']:>9.1f}")
+    errors = report["overall"]["errors"]
+    if errors:
+        print("errors: " + ", ".join(f"{outcome} x{n}" for outcome, n in sorted(errors.items())))
+    if report["overall"]["degraded"]:
+        print(f"degraded responses: {report['overall']['degraded']}")
+
+
+def compare(report, baseline, tolerance, error_tolerance):
+    """ Print the change against `baseline`; return the list of regressions. """
+
+    regressions = []
+    print(f"\n{'vs baseline':<28}{'metric':>14}{'baseline':>12}{'now':>12}{'change':>10}")
+    for label in ["overall"] + sorted(report["mix"]):
+        now = report["overall"] if label == "overall" else report["mix"].get(label)
+        base = baseline["overall"] if label == "overall" else baseline["mix"].get(label)
+        if now is None or base is None:
+            continue
+        for metric, higher_is_worse in (("p50_ms", True), ("p99_ms", True), ("throughput_rps", False)):
+            b, n = base[metric], now[metric]
+            change = (n - b) / b if b else 0.0
+            worse = change > tolerance if higher_is_worse else change < -tolerance
+            print(f"{label:<28}{metric:>14}{b:>12.1f}{n:>12.1f}{100 * change:>9.1f}%{'  !' if worse else ''}")
+            if worse and metric != "p50_ms":
+                regressions.append(f"{label} {metric}")
+        if now["error_rate"] > base["error_rate"] + error_tolerance:
+            print(f"{label:<28}{'error_rate':>14}{base['error_rate']:>12.3f}{now['error_rate']:>12.3f}  !")
+            regressions.append(f"{label} error_rate")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Load-test /api/solve and report latency percentiles.")
+    parser.add_argument("--url", default="http://127.0.0.1:5000", help="server base URL")
+    load = parser.add_mutually_exclusive_group()
+    load.add_argument("--qps", type=float, help="target request rate (open loop)")
+    load.add_argument("--concurrency", type=int, default=4,
+                      help="requests in flight (closed loop, default 4)")
+    parser.add_argument("--duration", type=float, default=30.0, help="seconds of load")
+    parser.add_argument("--mix", nargs="+", default=DEFAULT_MIX,
+                        help="size:algorithm:trace[:weight] entries (default: %(default)s)")
+    parser.add_argument("--distinct", type=int, default=32,
+                        help="different start/end pairs per mix entry (identical requests are coalesced)")
+    parser.add_argument("--timeout", type=float, default=30.0, help="per-request timeout in seconds")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--save", help="write the report as JSON to this file")
+    parser.add_argument("--baseline", help="compare against a report saved with --save")
+    parser.add_argument("--tolerance", type=float, default=0.2,
+                        help="allowed relative latency/throughput regression (default 0.2)")
+    parser.add_argument("--error-tolerance", type=float, default=0.01,
+                        help="allowed absolute error rate increase (default 0.01)")
+    args = parser.parse_args()
+
+    mix = parse_mix(args.mix)
+    bodies = build_bodies(mix, args.distinct, args.seed)
+    # Open loop needs enough senders to keep up while the server is slow
+    senders = min(MAX_SENDERS, max(1, int(args.qps * args.timeout))) if args.qps else args.concurrency
+    report = run_load(args.url.rstrip("/") + "/api/solve", mix, bodies, args.qps, senders,
+                      args.duration, args.timeout, args.seed)
+    report["config"] = {"qps": args.qps, "concurrency": None if args.qps else args.concurrency,
+                        "duration": args.duration, "mix": args.mix, "distinct": args.distinct}
+    print_report(report)
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(report, f, indent=1)
+    if args.baseline:
+        with open(args.baseline) as f:
+            regressions = compare(report, json.load(f), args.tolerance, args.error_tolerance)
+        if regressions:
+            print("\nregressions: " + ", ".join(regressions))
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
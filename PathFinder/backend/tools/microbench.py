@@ -0,0 +1,573 @@
+"""
+Microbenchmarks for the primitives the search loops are built from.
+
+Each benchmark times one variant of one primitive on a fixed, seeded workload:
+
+    heap/*        priority queues under a Dijkstra-like push/pop sequence with
+                  monotone integer keys: binary (heapq), 4-ary, pairing, bucket
+                  (Dial's) and radix heaps
+    neighbors/*   counting the free 4-neighbours of every free cell of a grid
+                  stored as nested lists, one padded flat bytearray, or 8x8
+                  tiles packed into ints
+    visited/*     per-search visited sets over many short searches: dict,
+                  bitset (bytearray) and a generation-stamped array that is
+                  never cleared
+    path/*        walking parent pointers back from the goal: tuple-keyed dict
+                  (as the algorithms do) and a flat parent array
+    encode/*      a solve response as JSON (default and compact separators,
+                  flat coordinate lists) and as raw int32 bytes
+
+The runner pins itself to one CPU when the OS allows it, warms each benchmark
+up, then takes --repeat samples of at least --min-time seconds each with the
+garbage collector off. It reports the median and spread in nanoseconds per
+item (pop, cell, lookup, path step or coordinate). --json saves the results
+with the interpreter and machine details. --baseline compares against a saved
+run and exits with status 1 when a median is slower by more than --tolerance.
+
+Usage (from the backend directory):
+    python -m tools.microbench
+    python -m tools.microbench --filter heap/ --json heaps.json
+    python -m tools.microbench --baseline heaps.json --filter heap/
+"""
+
+import argparse
+import gc
+import heapq
+import json
+import os
+import platform
+import random
+import statistics
+import sys
+import time
+from array import array
+
+from tools.benchmark import random_grid
+
+DIRS = ((-1, 0), (0, 1), (1, 0), (0, -1))
+MAX_STEP_COST = 16   # keys grow by 1..MAX_STEP_COST per push, as in a weighted Dijkstra
+TILE = 8
+
+
+# --- Heaps: push(key, item), pop() -> (key, item), len() ---------------------------
+
+class FourAryHeap:
+    """ Implicit 4-ary min-heap of (key, item) tuples: shallower than binary, more compares per level. """
+
+    def __init__(self):
+        self.items = []
+
+    def __len__(self):
+        return len(self.items)
+
+    def push(self, key, item):
+        items = self.items
+        entry = (key, item)
+        items.append(entry)
+        i = len(items) - 1
+        while i:
+            parent = (i - 1) >> 2
+            if items[parent] <= entry:
+                break
+            items[i] = items[parent]
+            i = parent
+        items[i] = entry
+
+    def pop(self):
+        items = self.items
+        top = items[0]
+        last = items.pop()
+        n = len(items)
+        if n:
+            i = 0
+            while True:
+                first = 4 * i + 1
+                if first >= n:
+                    break
+                child, best = first, items[first]
+                for k in range(first + 1, min(first + 4, n)):
+                    if items[k] < best:
+                        child, best = k, items[k]
+                if best >= last:
+                    break
+                items[i] = best
+                i = child
+            items[i] = last
+        return top
+
+
+class PairingHeap:
+    """ Pairing heap of [key, item, children] nodes; pop merges the children in two passes. """
+
+    def __init__(self):
+        self.root = None
+        self.size = 0
+
+    def __len__(self):
+        return self.size
+
+    @staticmethod
+    def _meld(a, b):
+        if b[0] < a[0]:
+            a, b = b, a
+        a[2].append(b)
+        return a
+
+    def push(self, key, item):
+        node = [key, item, []]
+        self.root = node if self.root is None else self._meld(self.root, node)
+        self.size += 1
+
+    def pop(self):
+        root = self.root
+        children = root[2]
+        meld = self._meld
+        pairs = [meld(children[i], children[i + 1]) if i + 1 < len(children) else children[i]
+                 for i in range(0, len(children), 2)]
+        merged = None
+        for node in reversed(pairs):
+            merged = node if merged is None else meld(node, merged)
+        self.root = merged
+        self.size -= 1
+        return root[0], root[1]
+
+
+class BucketQueue:
+    """ Dial's bucket queue: one list per integer key, scanned upwards (monotone keys only). """
+
+    def __init__(self):
+        self.buckets = []
+        self.current = 0
+        self.size = 0
+
+    def __len__(self):
+        return self.size
+
+    def push(self, key, item):
+        buckets = self.buckets
+        while len(buckets) <= key:
+            buckets.append([])
+        buckets[key].append(item)
+        self.size += 1
+
+    def pop(self):
+        buckets = self.buckets
+        while not buckets[self.current]:
+            self.current += 1
+        self.size -= 1
+        return self.current, buckets[self.current].pop()
+
+
+class RadixHeap:
+    """
+    Radix heap for monotone integer keys: bucket i holds keys whose highest bit
+    differing from the last popped key is bit i - 1, so each key moves down at
+    most once per bit.
+    """
+
+    def __init__(self):
+        self.buckets = [[] for _ in range(65)]
+        self.last = 0
+        self.size = 0
+
+    def __len__(self):
+        return self.size
+
+    def push(self, key, item):
+        self.buckets[(key ^ self.last).bit_length()].append((key, item))
+        self.size += 1
+
+    def pop(self):
+        buckets = self.buckets
+        if not buckets[0]:
+            i = 1
+            while not buckets[i]:
+                i += 1
+            entries = buckets[i]
+            buckets[i] = []
+            last = self.last = min(entries)[0]
+            for entry in entries:
+                buckets[(entry[0] ^ last).bit_length()].append(entry)
+        self.size -= 1
+        return buckets[0].pop()
+
+
+def heap_script(rng, pops):
+    """ Children per pop and their key increments, drawn up front so the timing only sees the heap. """
+
+    children = [rng.choice((1, 2, 2, 3, 3, 4)) for _ in range(pops)]
+    steps = [rng.randint(1, MAX_STEP_COST) for _ in range(sum(children))]
+    return children, steps
+
+
+def heapq_bench(script):
+    children, steps = script
+
+    def run():
+        heap = [(0, 0)]
+        push, pop = heapq.heappush, heapq.heappop
+        j = 0
+        for n in children:
+            key, item = pop(heap)
+            for _ in range(n):
+                push(heap, (key + steps[j], j))
+                j += 1
+    return run
+
+
+def heap_bench(cls):
+    def setup(script):
+        children, steps = script
+
+        def run():
+            heap = cls()
+            heap.push(0, 0)
+            push, pop = heap.push, heap.pop
+            j = 0
+            for n in children:
+                key, item = pop()
+                for _ in range(n):
+                    push(key + steps[j], j)
+                    j += 1
+        return run
+    return setup
+
+
+# --- Neighbour generation -----------------------------------------------------
+
+def neighbors_list(grid):
+    rows, cols = len(grid), len(grid[0])
+    free = [(r, c) for r in range(rows) for c in range(cols) if grid[r][c] == 0]
+
+    def run():
+        count = 0
+        for r, c in free:
+            for dr, dc in DIRS:
+                nr, nc = r + dr, c + dc
+                if 0 <= nr < rows and 0 <= nc < cols and grid[nr][nc] == 0:
+                    count += 1
+        return count
+    return run, len(free)
+
+
+def neighbors_flat(grid):
+    # One wall border all round, so no bounds checks
+    rows, cols = len(grid), len(grid[0])
+    width = cols + 2
+    cells = bytearray(b"\x01" * (width * (rows + 2)))
+    for r, row in enumerate(grid):
+        cells[(r + 1) * width + 1:(r + 1) * width + 1 + cols] = bytes(row)
+    free = [i for i in range(len(cells)) if cells[i] == 0]
+    offsets = (-width, 1, width, -1)
+
+    def run():
+        count = 0
+        for i in free:
+            for o in offsets:
+                if not cells[i + o]:
+                    count += 1
+        return count
+    return run, len(free)
+
+
+def neighbors_tiled(grid):
+    # Walls as one int per 8x8 tile; bit (r % 8) * 8 + c % 8; off-grid counts as wall
+    rows, cols = len(grid), len(grid[0])
+    tiles_across = (cols + TILE - 1) // TILE
+    tiles = [0] * (tiles_across * ((rows + TILE - 1) // TILE))
+    for r in range(rows):
+        for c in range(cols):
+            if grid[r][c]:
+                tiles[(r // TILE) * tiles_across + c // TILE] |= 1 << ((r % TILE) * TILE + c % TILE)
+    free = [(r, c) for r in range(rows) for c in range(cols) if grid[r][c] == 0]
+
+    def run():
+        count = 0
+        for r, c in free:
+            for dr, dc in DIRS:
+                nr, nc = r + dr, c + dc
+                if 0 <= nr < rows and 0 <= nc < cols and \
+                        not tiles[(nr >> 3) * tiles_across + (nc >> 3)] >> (((nr & 7) << 3) | (nc & 7)) & 1:
+                    count += 1
+        return count
+    return run, len(free)
+
+
+# --- Visited sets -------------------------------------------------------------
+
+def visited_script(rng, cells, searches, touches):
+    """ Per search, `touches` cell indices with repeats (re-reached cells are common). """
+
+    return [[rng.randrange(cells) if rng.random() < 0.7 else rng.randrange(min(cells, 64))
+             for _ in range(touches)] for _ in range(searches)], cells
+
+
+def visited_dict(script):
+    searches, _ = script
+
+    def run():
+        for touches in searches:
+            seen = {}
+            for i in touches:
+                if i not in seen:
+                    seen[i] = True
+    return run
+
+
+def visited_bitset(script):
+    searches, cells = script
+
+    def run():
+        for touches in searches:
+            bits = bytearray((cells + 7) >> 3)
+            for i in touches:
+                byte, mask = i >> 3, 1 << (i & 7)
+                if not bits[byte] & mask:
+                    bits[byte] |= mask
+    return run
+
+
+def visited_stamped(script):
+    searches, cells = script
+    stamps = array("I", bytes(4 * cells))
+    generation = [0]
+
+    def run():
+        for touches in searches:
+            generation[0] += 1   # a new search: every old stamp is stale, nothing to clear
+            g = generation[0]
+            for i in touches:
+                if stamps[i] != g:
+                    stamps[i] = g
+    return run
+
+
+# --- Path reconstruction --------------------------------------------------------
+
+def snake_path(rows, cols):
+    """ A boustrophedon walk over the whole grid: the longest simple path, as (r, c) cells. """
+
+    return [(r, c if r % 2 == 0 else cols - 1 - c) for r in range(rows) for c in range(cols)]
+
+
+def path_dict(cells):
+    parent = {b: a for a, b in zip(cells, cells[1:])}
+    start, end = cells[0], cells[-1]
+
+    def run():
+        path = []
+        node = end
+        while node != start:
+            path.append([node[0], node[1]])
+            node = parent[node]
+        path.append([start[0], start[1]])
+        path.reverse()
+        return path
+    return run
+
+
+def path_flat(cells, cols):
+    parent = array("i", bytes(4 * len(cells)))
+    index = [r * cols + c for r, c in cells]
+    for a, b in zip(index, index[1:]):
+        parent[b] = a
+    start, end = index[0], index[-1]
+
+    def run():
+        path = array("i")
+        node = end
+        while node != start:
+            path.append(node)
+            node = parent[node]
+        path.append(start)
+        path.reverse()
+        return path
+    return run
+
+
+# --- Response encoding ----------------------------------------------------------
+# Every variant starts from the algorithms' nested [row, col] lists, so any
+# flattening is part of the timed work
+
+def encode_json(result, **kwargs):
+    return lambda: json.dumps(result, **kwargs).encode()
+
+
+def encode_flat_json(visited, path):
+    def run():
+        flat_visited = [v for cell in visited for v in cell]
+        flat_path = [v for cell in path for v in cell]
+        return json.dumps({"visited": flat_visited, "path": flat_path}, separators=(",", ":")).encode()
+    return run
+
+
+def encode_binary(visited, path):
+    def run():
+        flat_visited = array("i", [v for cell in visited for v in cell])
+        flat_path = array("i", [v for cell in path for v in cell])
+        return array("i", (len(flat_visited), len(flat_path))).tobytes() \
+            + flat_visited.tobytes() + flat_path.tobytes()
+    return run
+
+
+# --- Registry -----------------------------------------------------------------
+
+def build_benchmarks(size, seed):
+    """ {name: (run, items per run)} on workloads sized from the grid side `size`. """
+
+    rng = random.Random(seed)
+    grid = random_grid(rng, size, size, 0.25)
+    benchmarks = {}
+
+    pops = size * size
+    script = heap_script(rng, pops)
+    benchmarks["heap/binary"] = (heapq_bench(script), pops)
+    for name, cls in (("4ary", FourAryHeap), ("pairing", PairingHeap),
+                      ("bucket", BucketQueue), ("radix", RadixHeap)):
+        benchmarks[f"heap/{name}"] = (heap_bench(cls)(script), pops)
+
+    for name, setup in (("list", neighbors_list), ("flat", neighbors_flat), ("tiled", neighbors_tiled)):
+        benchmarks[f"neighbors/{name}"] = setup(grid)
+
+    searches, touches = 64, max(16, size * size // 16)
+    script = visited_script(rng, size * size, searches, touches)
+    for name, setup in (("dict", visited_dict), ("bitset", visited_bitset), ("stamped", visited_stamped)):
+        benchmarks[f"visited/{name}"] = (setup(script), searches * touches)
+
+    cells = snake_path(size, size)
+    benchmarks["path/dict"] = (path_dict(cells), len(cells))
+    benchmarks["path/flat"] = (path_flat(cells, size), len(cells))
+
+    visited = [[r, c] for r, c in cells]
+    path = visited[: 2 * size]
+    result = {"visited": visited, "path": path}
+    coordinates = len(visited) + len(path)
+    benchmarks["encode/json"] = (encode_json(result), coordinates)
+    benchmarks["encode/json_compact"] = (encode_json(result, separators=(",", ":")), coordinates)
+    benchmarks["encode/flat_json"] = (encode_flat_json(visited, path), coordinates)
+    benchmarks["encode/binary"] = (encode_binary(visited, path), coordinates)
+    return benchmarks
+
+
+# --- Runner ---------------------------------------------------------------------
+
+def pin_cpu(cpu):
+    """ Pin this process to `cpu` (default: the last one it may run on); returns it, or None. """
+
+    if not hasattr(os, "sched_setaffinity"):
+        return None
+    allowed = sorted(os.sched_getaffinity(0))
+    cpu = allowed[-1] if cpu is None else cpu
+    os.sched_setaffinity(0, {cpu})
+    return cpu
+
+
+def measure(run, items, warmup, repeat, min_time):
+    """ Median, min and relative spread of ns per item over `repeat` timed samples. """
+
+    for _ in range(warmup):
+        run()
+    # Enough calls per sample to last at least min_time
+    loops = 1
+    while True:
+        t0 = time.perf_counter_ns()
+        for _ in range(loops):
+            run()
+        if time.perf_counter_ns() - t0 >= min_time * 1e9:
+            break
+        loops *= 2
+
+    samples = []
+    gc_was_enabled = gc.isenabled()
+    gc.disable()
+    try:
+        for _ in range(repeat):
+            t0 = time.perf_counter_ns()
+            for _ in range(loops):
+                run()
+            samples.append((time.perf_counter_ns() - t0) / (loops * items))
+    finally:
+        if gc_was_enabled:
+            gc.enable()
+    median = statistics.median(samples)
+    return {
+        "ns_per_item": median,
+        "min_ns_per_item": min(samples),
+        "spread": (statistics.stdev(samples) / median) if len(samples) > 1 and median else 0.0,
+        "items": items,
+        "loops": loops,
+    }
+
+
+def environment(cpu, args):
+    return {
+        "python": sys.version.split()[0],
+        "implementation": platform.python_implementation(),
+        "platform": platform.platform(),
+        "machine": platform.machine(),
+        "cpus": os.cpu_count(),
+        "pinned_cpu": cpu,
+        "size": args.size,
+        "seed": args.seed,
+        "repeat": args.repeat,
+    }
+
+
+def compare(results, baseline, tolerance):
+    """ Print the change against `baseline`; return the names that got slower beyond `tolerance`. """
+
+    regressions = []
+    print(f"\n{'vs baseline':<24}{'baseline':>12}{'now':>12}{'change':>10}")
+    for name, r in results.items():
+        base = baseline["results"].get(name)
+        if base is None:
+            continue
+        b, n = base["ns_per_item"], r["ns_per_item"]
+        change = (n - b) / b if b else 0.0
+        worse = change > tolerance
+        print(f"{name:<24}{b:>12.1f}{n:>12.1f}{100 * change:>9.1f}%{'  !' if worse else ''}")
+        if worse:
+            regressions.append(name)
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Microbenchmark the search primitives.")
+    parser.add_argument("--size", type=int, default=128, help="grid side the workloads are sized from")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--filter", nargs="+", default=[], help="only benchmarks whose name contains one of these")
+    parser.add_argument("--warmup", type=int, default=3, help="untimed runs before sampling")
+    parser.add_argument("--repeat", type=int, default=7, help="timed samples per benchmark")
+    parser.add_argument("--min-time", type=float, default=0.05, help="minimum seconds per sample")
+    parser.add_argument("--cpu", type=int, help="CPU to pin to (default: the last allowed one)")
+    parser.add_argument("--no-pin", action="store_true", help="do not change CPU affinity")
+    parser.add_argument("--json", help="write the results to this file")
+    parser.add_argument("--baseline", help="compare against a file written by --json")
+    parser.add_argument("--tolerance", type=float, default=0.1,
+                        help="allowed relative slowdown of a median (default 0.1)")
+    args = parser.parse_args()
+
+    cpu = None if args.no_pin else pin_cpu(args.cpu)
+    benchmarks = build_benchmarks(args.size, args.seed)
+    if args.filter:
+        benchmarks = {name: b for name, b in benchmarks.items() if any(f in name for f in args.filter)}
+
+    results = {}
+    print(f"{'benchmark':<24}{'ns/item':>12}{'min':>12}{'spread':>9}")
+    for name, (run, items) in benchmarks.items():
+        r = results[name] = measure(run, items, args.warmup, args.repeat, args.min_time)
+        print(f"{name:<24}{r['ns_per_item']:>12.1f}{r['min_ns_per_item']:>12.1f}{100 * r['spread']:>8.1f}%")
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"environment": environment(cpu, args), "results": results}, f, indent=1)
+    if args.baseline:
+        with open(args.baseline) as f:
+            regressions = compare(results, json.load(f), args.tolerance)
+        if regressions:
+            print("\nregressions: " + ", ".join(regressions))
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
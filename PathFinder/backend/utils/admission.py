@@ -0,0 +1,207 @@
+"""
+Admission control for the synchronous search endpoints.
+
+Searches run in a fixed number of slots; requests beyond that wait in one
+FIFO queue per priority class, and interactive requests are always let in
+before batch ones. On arrival each request gets a cost estimate (grid cells x
+a per-algorithm rate x a trace-level factor), and the controller predicts its
+queue wait from the estimated work already running and queued ahead of it:
+
+    predicted wait <= SLO                 admitted as asked
+    SLO < predicted wait <= shed x SLO    admitted degraded (the caller runs a
+                                          cheaper variant: no trace, weighted A*)
+    beyond that, or the queue is full     rejected with OverloadedError
+
+The per-algorithm rates start from rough priors and follow the measured run
+times (exponentially weighted), so the estimates track the real server.
+"""
+
+import threading
+import time
+from collections import deque
+
+PRIORITIES = ("interactive", "batch")
+DEFAULT_SLOTS = 2
+SLO_MS = {"interactive": 500.0, "batch": 10_000.0}
+SHED_FACTOR = 4.0
+MAX_QUEUED = {"interactive": 64, "batch": 256}
+
+# Rough cost of one grid cell in microseconds; the plain searches build
+# per-cell tables up front, so even a short search pays for the whole grid
+DEFAULT_US_PER_CELL = 2.0
+PRIOR_US_PER_CELL = {
+    "bfs": 1.0,
+    "dfs": 1.0,
+    "visibility": 4.0,
+    "block_astar": 0.5,
+}
+TRACE_FACTOR = {"none": 1.0, "sampled": 1.05, "full": 1.3, "frontier": 2.5}
+# Degraded runs skip the trace and expand far fewer nodes
+DEGRADED_FACTOR = 0.3
+EWMA_ALPHA = 0.2
+WAIT_SAMPLES = 1000
+
+
+class OverloadedError(Exception):
+    """ The request was shed; `retry_after` is a suggested wait in seconds. """
+
+    def __init__(self, message, retry_after):
+        super().__init__(message)
+        self.retry_after = retry_after
+
+
+class Ticket:
+    """ One admitted request; release() it when the search is done. """
+
+    def __init__(self, controller, priority, algorithm, cells, cost_ms, degraded, trace_factor=1.0):
+        self.controller = controller
+        self.priority = priority
+        self.algorithm = algorithm
+        self.cells = cells
+        self.cost_ms = cost_ms
+        self.degraded = degraded
+        self.trace_factor = trace_factor   # TRACE_FACTOR of the level it runs at
+        self.queued_at = time.perf_counter()
+        self.started_at = None
+
+    def release(self):
+        self.controller._release(self)
+
+
+def _percentile(samples, q):
+    if not samples:
+        return 0.0
+    ordered = sorted(samples)
+    return ordered[min(len(ordered) - 1, int(q * len(ordered)))]
+
+
+class AdmissionController:
+    def __init__(self, slots=DEFAULT_SLOTS, slo_ms=SLO_MS, shed_factor=SHED_FACTOR, max_queued=MAX_QUEUED):
+        self.slots = slots
+        self.slo_ms = dict(slo_ms)
+        self.shed_factor = shed_factor
+        self.max_queued = dict(max_queued)
+        self._us_per_cell = {}
+        self._queues = {priority: deque() for priority in PRIORITIES}
+        self._running = []
+        self._lock = threading.Condition()
+        self._counts = {priority: {"admitted": 0, "degraded": 0, "shed": 0} for priority in PRIORITIES}
+        self._waits = {priority: deque(maxlen=WAIT_SAMPLES) for priority in PRIORITIES}
+
+    def estimate_ms(self, algorithm, cells, trace_level="full", degraded=False):
+        """ Predicted run time of one search, in milliseconds. """
+
+        rate = self._us_per_cell.get(algorithm, PRIOR_US_PER_CELL.get(algorithm, DEFAULT_US_PER_CELL))
+        factor = DEGRADED_FACTOR if degraded else TRACE_FACTOR.get(trace_level, 1.0)
+        return cells * rate * factor / 1000.0
+
+    def _predicted_wait_ms(self, priority):
+        # Work that will run before a new request of this class: what is running
+        # now (minus what it has done), and what is queued ahead of it
+        now = time.perf_counter()
+        ahead = sum(max(0.0, t.cost_ms - 1000.0 * (now - t.started_at)) for t in self._running)
+        classes = PRIORITIES[:PRIORITIES.index(priority) + 1]
+        ahead += sum(t.cost_ms for p in classes for t in self._queues[p])
+        if len(self._running) < self.slots and not any(self._queues[p] for p in classes):
+            return 0.0
+        return ahead / self.slots
+
+    def _shed_if_busy(self, priority):
+        # Caller holds the lock; returns the predicted wait when not shed
+        wait = self._predicted_wait_ms(priority)
+        if wait > self.shed_factor * self.slo_ms[priority] \
+                or len(self._queues[priority]) >= self.max_queued[priority]:
+            self._counts[priority]["shed"] += 1
+            raise OverloadedError(
+                f"Server busy: predicted queue wait {wait:.0f} ms exceeds the {priority} limit.",
+                retry_after=max(1, round(wait / 1000.0)))
+        return wait
+
+    def check(self, priority):
+        """
+        Raise OverloadedError if a request of this class would be shed right
+        now, without queuing one: for work accepted now and run later (jobs).
+        """
+
+        if priority not in PRIORITIES:
+            raise ValueError(f"Unknown priority '{priority}'. Supported: {PRIORITIES}.")
+        with self._lock:
+            self._shed_if_busy(priority)
+
+    def acquire(self, priority, algorithm, cells, trace_level="full", can_degrade=True, can_shed=True):
+        """
+        Wait for a search slot and return a Ticket; `ticket.degraded` tells the
+        caller to run the cheap variant. Raises OverloadedError when shed
+        (never with can_shed=False, for work already admitted by check()), or
+        ValueError for an unknown priority.
+        """
+
+        if priority not in PRIORITIES:
+            raise ValueError(f"Unknown priority '{priority}'. Supported: {PRIORITIES}.")
+        slo = self.slo_ms[priority]
+        with self._lock:
+            wait = self._shed_if_busy(priority) if can_shed else self._predicted_wait_ms(priority)
+            counts = self._counts[priority]
+            degraded = can_degrade and wait > slo
+            cost = self.estimate_ms(algorithm, cells, trace_level, degraded)
+            ticket = Ticket(self, priority, algorithm, cells, cost, degraded, TRACE_FACTOR.get(trace_level, 1.0))
+            counts["admitted"] += 1
+            counts["degraded"] += degraded
+
+            queue = self._queues[priority]
+            queue.append(ticket)
+            self._lock.wait_for(lambda: self._next_up() is ticket)
+            queue.popleft()
+            ticket.started_at = time.perf_counter()
+            self._running.append(ticket)
+            self._waits[priority].append(1000.0 * (ticket.started_at - ticket.queued_at))
+            self._lock.notify_all()
+            return ticket
+
+    def _next_up(self):
+        # The ticket allowed to take the next free slot, if there is one
+        if len(self._running) >= self.slots:
+            return None
+        for priority in PRIORITIES:
+            if self._queues[priority]:
+                return self._queues[priority][0]
+        return None
+
+    def _release(self, ticket):
+        elapsed_ms = 1000.0 * (time.perf_counter() - ticket.started_at)
+        with self._lock:
+            self._running.remove(ticket)
+            # Learn the per-cell rate from full-cost runs only, with the trace
+            # level's overhead taken out again: estimate_ms() applies it
+            if not ticket.degraded and ticket.cells:
+                observed = 1000.0 * elapsed_ms / ticket.cells / ticket.trace_factor
+                prior = self._us_per_cell.get(ticket.algorithm,
+                                              PRIOR_US_PER_CELL.get(ticket.algorithm, DEFAULT_US_PER_CELL))
+                self._us_per_cell[ticket.algorithm] = prior + EWMA_ALPHA * (observed - prior)
+            self._lock.notify_all()
+
+    def metrics(self):
+        """ Queue lengths, counters and recent queue waits per class, plus the learned rates. """
+
+        with self._lock:
+            classes = {}
+            for priority in PRIORITIES:
+                waits = list(self._waits[priority])
+                classes[priority] = {
+                    "queued": len(self._queues[priority]),
+                    "running": sum(t.priority == priority for t in self._running),
+                    **self._counts[priority],
+                    "wait_ms_p50": _percentile(waits, 0.50),
+                    "wait_ms_p99": _percentile(waits, 0.99),
+                    "slo_ms": self.slo_ms[priority],
+                    "predicted_wait_ms": self._predicted_wait_ms(priority),
+                }
+            return {
+                "slots": self.slots,
+                "classes": classes,
+                "us_per_cell": dict(self._us_per_cell),
+            }
+
+
+# Shared by the request handlers
+admission = AdmissionController()
@@ -0,0 +1,46 @@
+"""
+Derived tables: structures computed from one map version and reused by every
+query on it.
+
+A stored MapSnapshot builds a table the first time a query asks for it and
+keeps it for the snapshot's lifetime. Tables are never modified afterwards,
+so searches still running on an old version keep a consistent view after a
+newer one goes live. A new version derives its tables from the previous
+version's where that is cheaper than building them from scratch. Tables with
+a codec can also be kept on disk across restarts (utils/table_cache.py).
+
+Tables:
+    visibility   VisibilityGraph of the map's convex corners (visibility_graph_search)
+"""
+
+from algorithms.visibility_graph import VisibilityGraph, derive_visibility_graph
+
+
+def _build_visibility(snapshot, previous):
+    return derive_visibility_graph(snapshot.grid, previous)
+
+
+def _load_visibility(snapshot, sections):
+    return VisibilityGraph.from_sections(snapshot.grid, sections)
+
+
+# name -> builder(snapshot, the previous version's table of that name or None)
+TABLE_BUILDERS = {
+    "visibility": _build_visibility,
+}
+
+# name -> (codec version, encode(table) -> list of arrays, decode(snapshot, sections) -> table);
+# bump the version whenever a table's layout or meaning changes
+TABLE_CODECS = {
+    "visibility": (1, VisibilityGraph.to_sections, _load_visibility),
+}
+
+# name -> estimated size in bytes of a built table, for memory accounting (utils/residency.py)
+TABLE_SIZES = {
+    "visibility": VisibilityGraph.memory_bytes,
+}
+
+# algorithm key -> (table name, keyword argument the algorithm takes it as)
+ALGORITHM_TABLES = {
+    "visibility": ("visibility", "graph"),
+}
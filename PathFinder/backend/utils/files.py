@@ -0,0 +1,21 @@
+"""
+File helpers shared by the on-disk stores.
+"""
+
+import os
+import tempfile
+
+
+def write_atomic(path, chunks):
+    """ Write `chunks` (bytes-like) to `path` through a temporary file, so readers never see a partial file. """
+
+    fd, tmp = tempfile.mkstemp(dir=os.path.dirname(path), prefix=".tmp-")
+    try:
+        with os.fdopen(fd, "wb") as f:
+            for chunk in chunks:
+                f.write(chunk)
+        os.replace(tmp, path)
+    except BaseException:
+        if os.path.exists(tmp):
+            os.unlink(tmp)
+        raise
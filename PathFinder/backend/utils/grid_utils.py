@@ -1,6 +1,6 @@
 """
 Utility functions for validating and parsing the grid and point data
-received from the front end payload.
+received from the front end payload, and for viewing grid buffers as rows.
 """
 
 def validate_grid(grid):
@@ -80,3 +80,34 @@ def parse_payload(data, supported_algorithms=None):
             raise ValueError(f"Invalid algorithm '{algo}'. Supported: {supported_algorithms}.")
         algo = algo.lower()
     return grid, start, end, algo
+
+
+def as_grid(cells, shape=None):
+    """
+    Rows indexable as grid[r][c] over `cells`, without copying the cells.
+
+    `cells` is a 2D list (returned as is) or any C-contiguous buffer of
+    one-byte cells: a numpy uint8 or bool array, bytes, bytearray, mmap,
+    memoryview... A 2D buffer brings its own shape; a flat one needs
+    shape=(rows, cols). Cells must be 0 (empty) or 1 (wall); they are not
+    checked, since that would mean reading the whole buffer.
+    """
+
+    if isinstance(cells, list):
+        return cells
+    view = memoryview(cells)
+    if not view.c_contiguous:
+        raise ValueError("Grid buffer must be C-contiguous (see numpy.ascontiguousarray).")
+    if view.itemsize != 1:
+        raise ValueError(f"Grid cells must be one byte each (uint8 or bool), not format '{view.format}'.")
+    if shape is None:
+        if view.ndim != 2:
+            raise ValueError("A grid buffer that is not 2D needs shape=(rows, cols).")
+        shape = view.shape
+    rows, cols = shape
+    if rows < 1 or cols < 1 or rows * cols != view.nbytes:
+        raise ValueError(f"Grid shape {rows}x{cols} does not match the buffer's {view.nbytes} bytes.")
+
+    # Row views into the same memory; only the row objects are new
+    flat = view.cast("B")
+    return [flat[r * cols:(r + 1) * cols] for r in range(rows)]
@@ -0,0 +1,235 @@
+"""
+In-process job queue for searches and map builds too slow for one request.
+
+A job is submitted with a priority class and runs later on a small pool of
+worker threads. Clients poll its state, or stream it as server-sent events,
+and fetch the result when it is done. Results are kept pre-encoded (bytes
+plus a mimetype) so fetching one costs nothing but the transfer.
+
+Priority classes:
+    interactive  solves someone is waiting on; always taken first
+    batch        preprocessing, huge maps, traces; may use at most
+                 `workers - 1` threads so one is always free for interactive work
+
+Job states: queued -> running -> done | failed, or cancelled at any point
+before it finishes. A running job notices cancellation the next time it
+reports progress.
+
+At most `max_queued` jobs wait at once; submit() raises QueueFullError beyond
+that rather than letting the backlog grow without bound.
+"""
+
+import threading
+import time
+import uuid
+from collections import OrderedDict, deque
+
+PRIORITIES = ("interactive", "batch")
+DEFAULT_WORKERS = 2
+MAX_JOBS = 256
+MAX_QUEUED = 64
+# Suggested wait, in seconds, for a client whose job was refused
+RETRY_AFTER_S = 5
+FINISHED_STATES = ("done", "failed", "cancelled")
+
+
+class UnknownJobError(LookupError):
+    """ No job with the requested id (never submitted, or evicted). """
+
+
+class QueueFullError(Exception):
+    """ Too many jobs are waiting to take another; `retry_after` is a suggested wait in seconds. """
+
+    def __init__(self, message, retry_after=RETRY_AFTER_S):
+        super().__init__(message)
+        self.retry_after = retry_after
+
+
+class JobCancelled(Exception):
+    """ Raised inside a running job once it has been cancelled. """
+
+
+class Job:
+    """ One unit of queued work and everything a client can ask about it. """
+
+    def __init__(self, kind, priority, fn):
+        self.job_id = uuid.uuid4().hex
+        self.kind = kind
+        self.priority = priority
+        self.state = "queued"
+        self.progress = {}
+        self.error = None
+        self.result = None       # bytes, once done
+        self.mimetype = None
+        self.created = time.time()
+        self.started = None
+        self.finished = None
+        self.version = 0         # bumped on every change, for event streams
+        self._fn = fn
+        self._cancelled = False
+        self._changed = threading.Condition()
+
+    def _update(self, **fields):
+        with self._changed:
+            for name, value in fields.items():
+                setattr(self, name, value)
+            self.version += 1
+            self._changed.notify_all()
+
+    def report(self, **progress):
+        """ Called by the running job with progress counters; raises JobCancelled once cancelled. """
+
+        if self._cancelled:
+            raise JobCancelled()
+        self._update(progress=progress)
+
+    def wait(self, version, timeout):
+        """ Block until the job changes past `version` (or `timeout` seconds pass); return its status. """
+
+        with self._changed:
+            self._changed.wait_for(lambda: self.version > version, timeout)
+            return self.status()
+
+    def status(self):
+        """ JSON-ready view of the job (without its result). """
+
+        status = {
+            "job_id": self.job_id,
+            "kind": self.kind,
+            "priority": self.priority,
+            "state": self.state,
+            "progress": self.progress,
+            "version": self.version,
+            "created": self.created,
+            "started": self.started,
+            "finished": self.finished,
+        }
+        if self.error is not None:
+            status["error"] = self.error
+        return status
+
+    @property
+    def finished_state(self):
+        return self.state in FINISHED_STATES
+
+
+class JobQueue:
+    """ FIFO queue per priority class, served by daemon worker threads started on first use. """
+
+    def __init__(self, workers=DEFAULT_WORKERS, max_jobs=MAX_JOBS, max_queued=MAX_QUEUED):
+        self.workers = workers
+        self.batch_slots = max(1, workers - 1)
+        self.max_jobs = max_jobs
+        self.max_queued = max_queued
+        self._rejected = 0
+        self._jobs = OrderedDict()
+        self._queues = {priority: deque() for priority in PRIORITIES}
+        self._running_batch = 0
+        self._lock = threading.Condition()
+        self._threads = []
+
+    def submit(self, kind, fn, priority="batch"):
+        """
+        Queue `fn(job)`, which returns (body bytes, mimetype) and may call
+        job.report(...) as it goes. Raises ValueError for an unknown priority,
+        or QueueFullError when `max_queued` jobs are already waiting.
+        """
+
+        if priority not in PRIORITIES:
+            raise ValueError(f"Unknown priority '{priority}'. Supported: {PRIORITIES}.")
+        job = Job(kind, priority, fn)
+        with self._lock:
+            queued = sum(len(queue) for queue in self._queues.values())
+            if queued >= self.max_queued:
+                self._rejected += 1
+                raise QueueFullError(f"Job queue full: {queued} jobs waiting.")
+            self._start_workers()
+            self._jobs[job.job_id] = job
+            self._evict()
+            self._queues[priority].append(job)
+            self._lock.notify_all()
+        return job
+
+    def get(self, job_id):
+        """ The job with `job_id`; raises UnknownJobError. """
+
+        with self._lock:
+            job = self._jobs.get(job_id)
+        if job is None:
+            raise UnknownJobError(f"Unknown job '{job_id}'.")
+        return job
+
+    def cancel(self, job_id):
+        """ Cancel a queued or running job; finished jobs are left as they are. """
+
+        job = self.get(job_id)
+        with self._lock:
+            if job.finished_state:
+                return job
+            job._cancelled = True
+            if job.state == "queued":
+                self._queues[job.priority].remove(job)
+                job._update(state="cancelled", finished=time.time())
+        return job
+
+    def stats(self):
+        """
+        {"queued": {priority: n}, "running": n, "total": n} over the jobs still
+        held, plus "rejected": submissions refused because the queue was full.
+        """
+
+        with self._lock:
+            return {
+                "queued": {priority: len(queue) for priority, queue in self._queues.items()},
+                "running": sum(job.state == "running" for job in self._jobs.values()),
+                "total": len(self._jobs),
+                "rejected": self._rejected,
+            }
+
+    def _evict(self):
+        # Drop the oldest finished jobs beyond the limit; queued and running ones stay
+        excess = len(self._jobs) - self.max_jobs
+        for job_id in [j for j, job in self._jobs.items() if job.finished_state][:max(0, excess)]:
+            del self._jobs[job_id]
+
+    def _start_workers(self):
+        while len(self._threads) < self.workers:
+            thread = threading.Thread(target=self._work, name=f"job-worker-{len(self._threads)}", daemon=True)
+            self._threads.append(thread)
+            thread.start()
+
+    def _next_job(self):
+        # Interactive work first; batch work waits while its slots are full
+        with self._lock:
+            while True:
+                if self._queues["interactive"]:
+                    job = self._queues["interactive"].popleft()
+                    break
+                if self._queues["batch"] and self._running_batch < self.batch_slots:
+                    job = self._queues["batch"].popleft()
+                    self._running_batch += 1
+                    break
+                self._lock.wait()
+            job._update(state="running", started=time.time())
+            return job
+
+    def _work(self):
+        while True:
+            job = self._next_job()
+            try:
+                body, mimetype = job._fn(job)
+                job._update(state="done", result=body, mimetype=mimetype, finished=time.time())
+            except JobCancelled:
+                job._update(state="cancelled", finished=time.time())
+            except Exception as e:
+                job._update(state="failed", error=str(e), finished=time.time())
+            finally:
+                job._fn = None
+                with self._lock:
+                    if job.priority == "batch":
+                        self._running_batch -= 1
+                    self._lock.notify_all()
+
+
+# Shared by the request handlers
+job_queue = JobQueue()
@@ -0,0 +1,87 @@
+"""
+Packed-bitset line-of-sight helpers shared by the any-angle search engines.
+
+Each grid row is packed into a single Python int whose bit `c` is set when
+cell (row, c) is a wall, so a whole horizontal span of cells can be tested
+with one AND against a mask instead of one lookup per cell.
+
+Segments run between cell centres. A segment is considered blocked if it
+touches any wall cell, including passing exactly through a wall's corner,
+which keeps any-angle paths from squeezing diagonally between two walls.
+"""
+
+
+def pack_rows(grid):
+    """ Pack a 2D list of 0/1 cells into one wall bitmask per row. """
+
+    packed = []
+    for row in grid:
+        bits = 0
+        for c, cell in enumerate(row):
+            if cell == 1:
+                bits |= 1 << c
+        packed.append(bits)
+    return packed
+
+
+def _ceil_div(a, b):
+    return -((-a) // b)
+
+
+def segment_spans(a, b):
+    """
+    Yield (row, first_col, last_col) for every row the segment a -> b touches,
+    ordered from a towards b. Each span contains the column where the segment
+    left the previous row, so consecutive spans always overlap.
+    """
+
+    r0, c0 = a
+    r1, c1 = b
+    if r0 == r1:
+        yield r0, min(c0, c1), max(c0, c1)
+        return
+
+    step = 1 if r1 > r0 else -1
+    dy = abs(r1 - r0)
+    dx = c1 - c0
+    # Work in units of 1 / (2 * dy) so every boundary crossing is an integer:
+    # at half-row offset t (0..2*dy) the column is (2*dy*c0 + t*dx) / (2*dy).
+    denom = 2 * dy
+    for i in range(dy + 1):
+        t_lo = max(2 * i - 1, 0)
+        t_hi = min(2 * i + 1, denom)
+        x_lo = denom * c0 + t_lo * dx
+        x_hi = denom * c0 + t_hi * dx
+        if x_lo > x_hi:
+            x_lo, x_hi = x_hi, x_lo
+        # Columns whose closed extent [c - 0.5, c + 0.5] meets [x_lo, x_hi].
+        first = _ceil_div(2 * x_lo - denom, 2 * denom)
+        last = (2 * x_hi + denom) // (2 * denom)
+        yield r0 + step * i, first, last
+
+
+def line_of_sight(packed, a, b):
+    """ Return True if the segment between cell centres a and b touches no wall. """
+
+    for r, first, last in segment_spans(a, b):
+        mask = ((1 << (last - first + 1)) - 1) << first
+        if packed[r] & mask:
+            return False
+    return True
+
+
+def segment_cells(a, b):
+    """ Return a 4-connected list of [row, col] cells from a to b along the segment a -> b. """
+
+    cells = []
+    forward = b[1] >= a[1]
+    entry = None
+    for r, first, last in segment_spans(a, b):
+        if forward:
+            cols = range(first if entry is None else entry, last + 1)
+            entry = last
+        else:
+            cols = range(last if entry is None else entry, first - 1, -1)
+            entry = first
+        cells.extend([r, c] for c in cols)
+    return cells
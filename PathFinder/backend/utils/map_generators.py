@@ -0,0 +1,297 @@
+"""
+Seeded procedural map generators for benchmarks and load tests.
+
+Every generator takes (rows, cols, rng, **params) and returns the grid as a
+list of bytearray rows (0 = empty, 1 = wall), the packed form the map store
+keeps and the algorithms index like a 2D list. The same seed and parameters
+always give the same map.
+
+Generators:
+    random     independent obstacles at an exact target `density`
+    division   recursive-division maze
+    prim       randomized Prim maze
+    kruskal    randomized Kruskal maze
+    caves      cellular-automata caves (`density` is the initial fill, `steps` smoothing passes)
+    rooms      rectangular rooms joined by L-shaped corridors (`rooms` placement attempts)
+    city       street grid of buildings, parks and alleys (`block` size, `street` width)
+"""
+
+import random
+
+# Generation runs in the request thread; past this size it takes minutes
+MAX_CELLS = 4_000 * 4_000
+# The automaton has settled long before this; it bounds the work a request can ask for
+MAX_CAVE_STEPS = 20
+
+
+def _filled(rows, cols, value):
+    return [bytearray([value]) * cols for _ in range(rows)]
+
+
+def random_obstacles(rows, cols, rng, density=0.25):
+    if not 0.0 <= density <= 1.0:
+        raise ValueError("density must be between 0 and 1.")
+    cells = bytearray(rows * cols)
+    for i in rng.sample(range(rows * cols), round(density * rows * cols)):
+        cells[i] = 1
+    return [cells[r * cols:(r + 1) * cols] for r in range(rows)]
+
+
+# Mazes: passages on odd (row, col), walls in between; an even row/col count
+# leaves the last row/column solid. Maze rooms are numbered i = y * width + x
+# for the passage cell (2y + 1, 2x + 1).
+
+def _maze_size(rows, cols):
+    return max(0, (rows - 1) // 2), max(0, (cols - 1) // 2)
+
+
+def prim_maze(rows, cols, rng):
+    grid = _filled(rows, cols, 1)
+    height, width = _maze_size(rows, cols)
+    if not height or not width:
+        return grid
+    in_maze = bytearray(height * width)
+    # Frontier entries: (room inside the maze, neighbouring room)
+    frontier = []
+
+    def add(i):
+        in_maze[i] = 1
+        y, x = divmod(i, width)
+        grid[2 * y + 1][2 * x + 1] = 0
+        if y > 0 and not in_maze[i - width]:
+            frontier.append((i, i - width))
+        if x < width - 1 and not in_maze[i + 1]:
+            frontier.append((i, i + 1))
+        if y < height - 1 and not in_maze[i + width]:
+            frontier.append((i, i + width))
+        if x > 0 and not in_maze[i - 1]:
+            frontier.append((i, i - 1))
+
+    add(rng.randrange(height * width))
+    while frontier:
+        # Swap-remove a random entry
+        k = rng.randrange(len(frontier))
+        frontier[k], frontier[-1] = frontier[-1], frontier[k]
+        a, b = frontier.pop()
+        if not in_maze[b]:
+            (ya, xa), (yb, xb) = divmod(a, width), divmod(b, width)
+            grid[ya + yb + 1][xa + xb + 1] = 0
+            add(b)
+    return grid
+
+
+def kruskal_maze(rows, cols, rng):
+    grid = _filled(rows, cols, 1)
+    height, width = _maze_size(rows, cols)
+    parent = list(range(height * width))
+
+    def find(i):
+        while parent[i] != i:
+            parent[i] = parent[parent[i]]
+            i = parent[i]
+        return i
+
+    # Edge e joins room e >> 1 to its right (even e) or lower (odd e) neighbour
+    edges = []
+    for y in range(height):
+        grid[2 * y + 1][1:2 * width:2] = bytearray(width)
+        for x in range(width):
+            i = y * width + x
+            if x < width - 1:
+                edges.append(i << 1)
+            if y < height - 1:
+                edges.append(i << 1 | 1)
+    rng.shuffle(edges)
+    for e in edges:
+        i = e >> 1
+        j = i + (width if e & 1 else 1)
+        a, b = find(i), find(j)
+        if a != b:
+            parent[a] = b
+            y, x = divmod(i, width)
+            if e & 1:
+                grid[2 * y + 2][2 * x + 1] = 0
+            else:
+                grid[2 * y + 1][2 * x + 2] = 0
+    return grid
+
+
+def division_maze(rows, cols, rng):
+    grid = _filled(rows, cols, 0)
+    for c in range(cols):
+        grid[0][c] = grid[rows - 1][c] = 1
+    for r in range(rows):
+        grid[r][0] = grid[r][cols - 1] = 1
+    if rows % 2 == 0:
+        grid[rows - 2][:] = bytearray([1]) * cols
+    if cols % 2 == 0:
+        for r in range(rows):
+            grid[r][cols - 2] = 1
+
+    # Chambers as inclusive odd bounds (r0, c0, r1, c1); an explicit stack
+    # instead of recursion keeps huge maps clear of the recursion limit
+    stack = [(1, 1, rows - 2 - (rows % 2 == 0), cols - 2 - (cols % 2 == 0))]
+    while stack:
+        r0, c0, r1, c1 = stack.pop()
+        height, width = r1 - r0, c1 - c0
+        if height < 2 or width < 2:
+            continue
+        horizontal = height > width or (height == width and rng.random() < 0.5)
+        if horizontal:
+            wr = rng.randrange(r0 + 1, r1, 2)    # even row for the wall
+            gap = rng.randrange(c0, c1 + 1, 2)   # odd column for the passage
+            for c in range(c0, c1 + 1):
+                if c != gap:
+                    grid[wr][c] = 1
+            stack.append((r0, c0, wr - 1, c1))
+            stack.append((wr + 1, c0, r1, c1))
+        else:
+            wc = rng.randrange(c0 + 1, c1, 2)
+            gap = rng.randrange(r0, r1 + 1, 2)
+            for r in range(r0, r1 + 1):
+                if r != gap:
+                    grid[r][wc] = 1
+            stack.append((r0, c0, r1, wc - 1))
+            stack.append((r0, wc + 1, r1, c1))
+    return grid
+
+
+def _add_bits(a, b):
+    """ Bit-sliced addition of two little-endian lists of bit-plane ints. """
+
+    out = []
+    carry = 0
+    for i in range(max(len(a), len(b))):
+        x = a[i] if i < len(a) else 0
+        y = b[i] if i < len(b) else 0
+        out.append(x ^ y ^ carry)
+        carry = (x & y) | (carry & (x ^ y))
+    out.append(carry)
+    return out
+
+
+def caves(rows, cols, rng, density=0.45, steps=5):
+    """
+    Classic 4-5 cave automaton: a cell becomes wall with 5+ wall neighbors and
+    stays wall with 4+. Rows are bitmask ints, so each step counts all eight
+    neighbors of a whole row at once with bit-sliced adders.
+    """
+
+    if not 0.0 <= density <= 1.0:
+        raise ValueError("density must be between 0 and 1.")
+    if not 1 <= steps <= MAX_CAVE_STEPS:
+        raise ValueError(f"steps must be between 1 and {MAX_CAVE_STEPS}.")
+    full = (1 << cols) - 1
+    # Pad with a solid wall column on each side; outside rows are solid too
+    masks = [(sum(1 << c for c in range(cols) if rng.random() < density) << 1) | 1 | (1 << (cols + 1))
+             for _ in range(rows)]
+    solid = (full << 1) | 1 | (1 << (cols + 1))
+
+    for _ in range(steps):
+        padded = [solid] + masks + [solid]
+        nxt = []
+        for r in range(rows):
+            above, row, below = padded[r], padded[r + 1], padded[r + 2]
+            count = [0]
+            for m in (above << 1, above, above >> 1, row << 1, row >> 1, below << 1, below, below >> 1):
+                count = _add_bits(count, [m])
+            count += [0] * (4 - len(count))
+            b0, b1, b2, b3 = count[:4]
+            ge4 = b2 | b3
+            ge5 = b3 | (b2 & (b1 | b0))
+            cell = (ge5 | (row & ge4)) & (full << 1)
+            nxt.append(cell | 1 | (1 << (cols + 1)))
+        masks = nxt
+
+    grid = []
+    for m in masks:
+        bits = (m >> 1) & full
+        grid.append(bytearray((bits >> c) & 1 for c in range(cols)))
+    return grid
+
+
+def rooms_and_corridors(rows, cols, rng, rooms=None, min_size=4, max_size=12):
+    if not 1 <= min_size <= max_size:
+        raise ValueError("min_size must be at least 1 and at most max_size.")
+    if rooms is None:
+        # Enough attempts to fill a good share of the map at any size
+        rooms = max(1, rows * cols // (max_size * max_size))
+    elif not 0 <= rooms <= rows * cols // (min_size * min_size):
+        raise ValueError(f"rooms must be between 0 and {rows * cols // (min_size * min_size)} for this map.")
+    grid = _filled(rows, cols, 1)
+    placed = []
+    for _ in range(rooms):
+        h = rng.randint(min_size, max_size)
+        w = rng.randint(min_size, max_size)
+        if h > rows - 2 or w > cols - 2:
+            continue
+        r = rng.randint(1, rows - h - 1)
+        c = rng.randint(1, cols - w - 1)
+        # Keep a one-cell wall between rooms (corridors are carved afterwards)
+        if any(0 in grid[rr][c - 1:c + w + 1] for rr in range(r - 1, r + h + 1)):
+            continue
+        placed.append((r, c, h, w))
+        for rr in range(r, r + h):
+            grid[rr][c:c + w] = bytearray(w)
+
+    # Join rooms in left-to-right order of their centers with L-shaped corridors
+    centers = sorted(((pr + ph // 2, pc + pw // 2) for pr, pc, ph, pw in placed), key=lambda rc: (rc[1], rc[0]))
+    for (r1, c1), (r2, c2) in zip(centers, centers[1:]):
+        if rng.random() < 0.5:
+            r1, c1, r2, c2 = r2, c2, r1, c1
+        lo, hi = min(c1, c2), max(c1, c2)
+        grid[r1][lo:hi + 1] = bytearray(hi - lo + 1)
+        for r in range(min(r1, r2), max(r1, r2) + 1):
+            grid[r][c2] = 0
+    return grid
+
+
+def city_blocks(rows, cols, rng, block=12, street=3, park_chance=0.15, alley_chance=0.3):
+    if block <= street or street < 1:
+        raise ValueError("block must be larger than street, and street at least 1.")
+    grid = _filled(rows, cols, 0)
+    for r0 in range(street, rows, block):
+        for c0 in range(street, cols, block):
+            r1 = min(r0 + block - street, rows)
+            c1 = min(c0 + block - street, cols)
+            if rng.random() < park_chance:
+                continue
+            for r in range(r0, r1):
+                grid[r][c0:c1] = bytearray([1]) * (c1 - c0)
+            # Cut an alley through some buildings
+            if rng.random() < alley_chance and r1 - r0 > 2 and c1 - c0 > 2:
+                if rng.random() < 0.5:
+                    ar = rng.randrange(r0 + 1, r1 - 1)
+                    grid[ar][c0:c1] = bytearray(c1 - c0)
+                else:
+                    ac = rng.randrange(c0 + 1, c1 - 1)
+                    for r in range(r0, r1):
+                        grid[r][ac] = 0
+    return grid
+
+
+GENERATORS = {
+    "random": random_obstacles,
+    "division": division_maze,
+    "prim": prim_maze,
+    "kruskal": kruskal_maze,
+    "caves": caves,
+    "rooms": rooms_and_corridors,
+    "city": city_blocks,
+}
+
+
+def generate(kind, rows, cols, seed=0, **params):
+    """ Build a map with generator `kind`; raises ValueError for bad arguments. """
+
+    fn = GENERATORS.get(kind)
+    if fn is None:
+        raise ValueError(f"Unknown generator '{kind}'. Supported: {sorted(GENERATORS)}.")
+    if not isinstance(rows, int) or not isinstance(cols, int) or rows < 1 or cols < 1:
+        raise ValueError("rows and cols must be positive integers.")
+    if rows * cols > MAX_CELLS:
+        raise ValueError(f"Map has {rows * cols} cells; the limit is {MAX_CELLS}.")
+    try:
+        return fn(rows, cols, random.Random(seed), **params)
+    except TypeError as e:
+        raise ValueError(f"Bad parameters for generator '{kind}': {e}") from None
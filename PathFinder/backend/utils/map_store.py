@@ -0,0 +1,344 @@
+"""
+Server-side copies of the maps being edited in the frontend.
+
+A client uploads its grid once (POST /api/maps) and from then on sends only
+the cells each edit stroke changed, as run-length encoded deltas, so large
+edits and large maps stay cheap to keep in sync. Solve requests can then name
+the map by id instead of shipping the whole grid.
+
+Runs are a flat list of integers [start, length, value, start, length, value, ...]:
+`length` cells from row-major index `start` (row * cols + col) are set to
+`value` (0 = empty, 1 = wall). A new map starts empty and applies its runs.
+
+Each map is stored as a list of bytes/bytearray rows, which the algorithms
+index like the usual 2D list. Deltas are copy-on-write: they replace only the
+rows they touch, so a search already running on the previous version keeps a
+consistent grid.
+
+Every version also carries its derived tables (utils/derived.py), built on
+first use. Publishing a new version is a single reference swap, so a query
+sees either the old version or the new one, never a mix. A delta goes live
+at once, and the new version derives its tables lazily from the previous
+version's. A whole-map replacement (replace()) is staged instead. The tables
+the live version has built are prepared for the staged version in the
+background, and it is swapped in only once they are ready, so no query
+waits on a rebuild.
+
+Grids and tables are charged to one memory budget (utils/residency.py), which
+evicts tables before whole maps when it runs out.
+
+With PATHFINDER_SHARED_MAPS set, `map_store` keeps maps in memory-mapped files
+shared by all server processes instead (see utils/shared_map_store.py).
+"""
+
+import os
+import sys
+import threading
+import time
+import uuid
+import weakref
+from collections import OrderedDict
+from functools import partial
+
+from utils.derived import TABLE_BUILDERS, TABLE_SIZES
+from utils.residency import residency, GRID
+from utils.table_cache import table_cache, content_hash
+
+MAX_MAPS = 64
+MAX_CELLS = 10_000 * 10_000
+
+
+class UnknownMapError(LookupError):
+    """ No map with the requested id (never created, or evicted). """
+
+
+class VersionConflictError(ValueError):
+    """ A delta was based on a different version than the stored map. """
+
+
+class MapSnapshot:
+    """ One immutable version of a map, with its derived tables. """
+
+    def __init__(self, map_id, rows, cols, version, grid, previous=None):
+        self.map_id = map_id
+        self.rows = rows
+        self.cols = cols
+        self.version = version
+        self.grid = grid
+        # The version this one replaced; its tables seed ours (only one level is kept)
+        self.previous = previous
+        if previous is not None:
+            previous.previous = None
+        self._tables = {}
+        self._tables_lock = threading.Lock()
+        self._content_hash = None
+
+    def content_hash(self):
+        """ SHA-256 of the map's shape and cells, computed once. """
+
+        if self._content_hash is None:
+            self._content_hash = content_hash(self.rows, self.cols, self.grid)
+        return self._content_hash
+
+    def table(self, name):
+        """
+        Derived table `name` (see utils/derived.py), built on first use: from
+        the table cache if enabled, else from the previous version's, else anew.
+        """
+
+        with self._tables_lock:
+            table = self._tables.get(name)
+            if table is not None:
+                residency.touch(self.map_id, name)
+                return table
+            previous = self.previous
+            seed = previous._tables.get(name) if previous is not None else None
+            started = time.perf_counter()
+            if table_cache is not None:
+                table = table_cache.load(name, self)
+            if table is None:
+                table = TABLE_BUILDERS[name](self, seed)
+                if table_cache is not None and table is not seed:
+                    table_cache.maybe_save(name, self, table, 1000.0 * (time.perf_counter() - started))
+            build_ms = 1000.0 * (time.perf_counter() - started)
+            self._tables[name] = table
+            # Let the old version go once nothing is left to derive from it
+            if previous is not None and previous._tables.keys() <= self._tables.keys():
+                self.previous = None
+
+        # Charged outside the lock: eviction may drop tables of other snapshots
+        residency.charge(self.map_id, name, TABLE_SIZES[name](table),
+                         partial(_drop_table, weakref.ref(self), name), build_ms)
+        return table
+
+    def adopt_tables(self, other):
+        """ Take over the tables built on `other`, a snapshot of the same content. """
+
+        with other._tables_lock:
+            tables = dict(other._tables)
+        with self._tables_lock:
+            self._tables.update(tables)
+            self.previous = None
+        for name, table in tables.items():
+            residency.charge(self.map_id, name, TABLE_SIZES[name](table),
+                             partial(_drop_table, weakref.ref(self), name))
+
+    def drop_table(self, name):
+        """ Forget a built table (evicted); the next table(name) builds or loads it again. """
+
+        with self._tables_lock:
+            self._tables.pop(name, None)
+
+    def built_tables(self):
+        """ Names of the derived tables built so far. """
+
+        with self._tables_lock:
+            return list(self._tables)
+
+
+def _drop_table(ref, name):
+    # Eviction callback; the snapshot may already be gone
+    snapshot = ref()
+    if snapshot is not None:
+        snapshot.drop_table(name)
+
+
+def grid_bytes(grid):
+    """ Memory held by a grid of byte rows; rows shared by several indices are counted once. """
+
+    rows = {id(row): row for row in grid}
+    return sys.getsizeof(grid) + sum(sys.getsizeof(row) for row in rows.values())
+
+
+def _check_size(rows, cols):
+    if not isinstance(rows, int) or not isinstance(cols, int) or rows < 1 or cols < 1:
+        raise ValueError("Map rows and cols must be positive integers.")
+    if rows * cols > MAX_CELLS:
+        raise ValueError(f"Map has {rows * cols} cells; the limit is {MAX_CELLS}.")
+
+
+def _validate_runs(runs, size):
+    if not isinstance(runs, list) or len(runs) % 3 != 0:
+        raise ValueError("Runs must be a flat list of [start, length, value] triples.")
+    for i in range(0, len(runs), 3):
+        start, length, value = runs[i:i + 3]
+        if not all(isinstance(v, int) for v in (start, length, value)):
+            raise ValueError(f"Run {i // 3} contains non-integer values.")
+        if start < 0 or length < 1 or start + length > size:
+            raise ValueError(f"Run {i // 3} ({start}, {length}) is outside the grid.")
+        if value not in (0, 1):
+            raise ValueError(f"Run {i // 3} value must be 0 or 1.")
+
+
+def _apply_runs(grid, cols, runs):
+    """ Return `grid` with `runs` applied, copying only the rows they touch. """
+
+    grid = list(grid)
+    copied = set()
+    for i in range(0, len(runs), 3):
+        start, length, value = runs[i:i + 3]
+        end = start + length
+        pos = start
+        while pos < end:
+            r, c0 = divmod(pos, cols)
+            c1 = min(cols, c0 + end - pos)
+            if r not in copied:
+                grid[r] = bytearray(grid[r])
+                copied.add(r)
+            grid[r][c0:c1] = bytes([value]) * (c1 - c0)
+            pos += c1 - c0
+    return grid
+
+
+def encode_runs(grid):
+    """ Runs describing every wall of `grid`, applied to an empty map. """
+
+    runs = []
+    cols = len(grid[0]) if grid else 0
+    for r, row in enumerate(grid):
+        # Byte rows can be scanned with find(); other rows are packed first
+        row = bytes(row)
+        start = row.find(1)
+        while start != -1:
+            end = row.find(0, start)
+            if end == -1:
+                end = cols
+            runs.extend((r * cols + start, end - start, 1))
+            start = row.find(1, end)
+    return runs
+
+
+class MapStore:
+    """ Thread-safe, size-bounded store of map snapshots (least recently used evicted). """
+
+    def __init__(self, max_maps=MAX_MAPS):
+        self.max_maps = max_maps
+        self._maps = OrderedDict()
+        self._pending = {}   # map_id -> staged snapshot waiting for its tables
+        self._lock = threading.Lock()
+
+    def create(self, rows, cols, runs=()):
+        """ Store a new map and return its first snapshot (version 0). """
+
+        _check_size(rows, cols)
+        runs = list(runs)
+        _validate_runs(runs, rows * cols)
+
+        # Rows no run touches all share one immutable empty row
+        return self.store(rows, cols, _apply_runs([bytes(cols)] * rows, cols, runs))
+
+    def store(self, rows, cols, grid):
+        """ Store an already built grid (rows of bytes/bytearray) as a new map at version 0. """
+
+        snapshot = MapSnapshot(uuid.uuid4().hex, rows, cols, 0, grid)
+        with self._lock:
+            self._maps[snapshot.map_id] = snapshot
+            while len(self._maps) > self.max_maps:
+                residency.release(self._maps.popitem(last=False)[0])
+        self._charge(snapshot)
+        return snapshot
+
+    def get(self, map_id):
+        """ Current snapshot of `map_id`; raises UnknownMapError. """
+
+        with self._lock:
+            snapshot = self._maps.get(map_id)
+            if snapshot is None:
+                raise UnknownMapError(f"Unknown map '{map_id}'.")
+            self._maps.move_to_end(map_id)
+        residency.touch(map_id, GRID)
+        return snapshot
+
+    def apply(self, map_id, base_version, runs):
+        """
+        Apply a delta made against `base_version` and return the new snapshot.
+        Raises UnknownMapError, VersionConflictError, or ValueError for bad runs.
+        """
+
+        current = self.get(map_id)
+        _validate_runs(runs, current.rows * current.cols)
+        with self._lock:
+            current = self._latest(map_id, base_version)
+            grid = _apply_runs(current.grid, current.cols, runs)
+            snapshot = MapSnapshot(map_id, current.rows, current.cols, current.version + 1, grid, current)
+            self._maps[map_id] = snapshot
+            self._maps.move_to_end(map_id)
+        self._charge(snapshot)
+        return snapshot
+
+    def replace(self, map_id, base_version, rows, cols, runs):
+        """
+        Stage a whole new grid (runs applied to an empty map) as the next
+        version and return it. It goes live once the derived tables the
+        current version has built are ready for it; until then queries keep
+        getting the current version and further changes are refused.
+        """
+
+        _check_size(rows, cols)
+        runs = list(runs)
+        _validate_runs(runs, rows * cols)
+        grid = _apply_runs([bytes(cols)] * rows, cols, runs)
+        with self._lock:
+            current = self._latest(map_id, base_version)
+            staged = MapSnapshot(map_id, rows, cols, current.version + 1, grid, current)
+            self._pending[map_id] = staged
+        threading.Thread(target=self._prepare_and_swap, args=(staged, current.built_tables()),
+                         name=f"prepare-{map_id}", daemon=True).start()
+        return staged
+
+    def pending_version(self, map_id):
+        """ Version being prepared by replace(), or None. """
+
+        with self._lock:
+            staged = self._pending.get(map_id)
+            return staged.version if staged is not None else None
+
+    def _latest(self, map_id, base_version):
+        # The live snapshot a change may build on; caller holds the lock
+        current = self._maps.get(map_id)
+        if current is None:
+            raise UnknownMapError(f"Unknown map '{map_id}'.")
+        staged = self._pending.get(map_id)
+        if staged is not None:
+            raise VersionConflictError(f"Version {staged.version} is still being prepared.")
+        if current.version != base_version:
+            raise VersionConflictError(
+                f"Delta is based on version {base_version}, map is at {current.version}.")
+        return current
+
+    def _prepare_and_swap(self, staged, names):
+        swapped = False
+        try:
+            for name in names:
+                staged.table(name)
+        finally:
+            with self._lock:
+                if self._pending.get(staged.map_id) is staged:
+                    del self._pending[staged.map_id]
+                    # Unless the map was evicted meanwhile
+                    if staged.map_id in self._maps:
+                        self._maps[staged.map_id] = staged
+                        swapped = True
+            if swapped:
+                self._charge(staged)
+
+    def _charge(self, snapshot):
+        # Charge the live grid; evicting it drops the whole map
+        residency.charge(snapshot.map_id, GRID, grid_bytes(snapshot.grid),
+                         lambda: self._forget(snapshot.map_id))
+
+    def _forget(self, map_id):
+        with self._lock:
+            self._maps.pop(map_id, None)
+
+
+def _default_store():
+    root = os.environ.get("PATHFINDER_SHARED_MAPS")
+    if not root:
+        return MapStore()
+    from utils.shared_map_store import SharedMapStore
+    return SharedMapStore(root)
+
+
+# Shared by the request handlers
+map_store = _default_store()
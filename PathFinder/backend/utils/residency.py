@@ -0,0 +1,117 @@
+"""
+Memory accounting and eviction for stored maps and their derived tables.
+
+Every resident artifact (a map's grid, or one of its derived tables) is
+charged to one process-wide budget, PATHFINDER_MEMORY_MB (default 2048),
+with an estimate of its size. Using an artifact marks it recently used. When
+a new charge takes the total over budget, artifacts are evicted least
+recently used first. All derived tables go before any grid:
+
+    derived table   dropped from its snapshot; the next query that needs it
+                    loads it from the table cache or builds it again
+    grid            the store forgets the map (an in-memory map is gone and
+                    has to be uploaded again; a shared map is only unmapped
+                    and is mapped again on its next use)
+
+The artifact being charged is never evicted for itself, so a single map
+larger than the budget stays resident on its own. Caches shared by all maps
+are charged under a pseudo map id, such as block A*'s "block_astar" / "lddb",
+and are evicted like derived tables.
+"""
+
+import os
+import threading
+from collections import OrderedDict
+
+GRID = "grid"
+DEFAULT_BUDGET_MB = 2048
+
+
+class ResidencyManager:
+    """ LRU accounting of (map_id, artifact) sizes against one byte budget. """
+
+    def __init__(self, budget_bytes=DEFAULT_BUDGET_MB << 20):
+        self.budget_bytes = budget_bytes
+        # (map_id, artifact) -> [bytes, build ms, evict callback], least recently used first
+        self._entries = OrderedDict()
+        self._total = 0
+        self._evictions = {"tables": 0, "grids": 0}
+        self._lock = threading.Lock()
+
+    def charge(self, map_id, artifact, nbytes, evict, build_ms=0.0):
+        """
+        Account for a newly resident artifact (replacing any earlier charge for
+        the same key) and evict others while over budget. `evict()` is called,
+        without locks held, if this artifact is chosen later.
+        """
+
+        key = (map_id, artifact)
+        with self._lock:
+            old = self._entries.pop(key, None)
+            if old is not None:
+                self._total -= old[0]
+            self._entries[key] = [nbytes, build_ms, evict]
+            self._total += nbytes
+            victims = self._choose_victims(key)
+        for callback in victims:
+            callback()
+
+    def touch(self, map_id, artifact):
+        """ Mark an artifact as just used. """
+
+        with self._lock:
+            if (map_id, artifact) in self._entries:
+                self._entries.move_to_end((map_id, artifact))
+
+    def release(self, map_id, artifact=None):
+        """ Forget one artifact, or every artifact of `map_id`, without calling eviction callbacks. """
+
+        with self._lock:
+            keys = [(map_id, artifact)] if artifact is not None else \
+                [key for key in self._entries if key[0] == map_id]
+            for key in keys:
+                entry = self._entries.pop(key, None)
+                if entry is not None:
+                    self._total -= entry[0]
+
+    def _choose_victims(self, keep):
+        # Caller holds the lock; tables first, then grids, each least recently used first
+        victims = []
+        for wanted_grid in (False, True):
+            for key in list(self._entries):
+                if self._total <= self.budget_bytes:
+                    return victims
+                if key == keep or (key[1] == GRID) != wanted_grid:
+                    continue
+                if wanted_grid and key[0] == keep[0]:
+                    continue
+                # A map's tables go with its grid
+                doomed = [key] if not wanted_grid else [k for k in self._entries if k[0] == key[0]]
+                for k in doomed:
+                    nbytes, _, evict = self._entries.pop(k)
+                    self._total -= nbytes
+                    self._evictions["grids" if k[1] == GRID else "tables"] += 1
+                    victims.append(evict)
+        return victims
+
+    def metrics(self):
+        """ Budget, resident bytes by artifact kind, eviction counts, and per-map detail. """
+
+        with self._lock:
+            by_kind = {}
+            maps = OrderedDict()
+            for (map_id, artifact), (nbytes, build_ms, _) in reversed(self._entries.items()):
+                by_kind[artifact] = by_kind.get(artifact, 0) + nbytes
+                maps.setdefault(map_id, {})[artifact] = {"bytes": nbytes, "build_ms": round(build_ms, 1)}
+            return {
+                "budget_bytes": self.budget_bytes,
+                "resident_bytes": self._total,
+                "by_kind": by_kind,
+                "evictions": dict(self._evictions),
+                # Most recently used first
+                "maps": [{"map_id": map_id, "artifacts": artifacts} for map_id, artifacts in maps.items()],
+            }
+
+
+# Shared by the map stores
+residency = ResidencyManager(int(os.environ.get("PATHFINDER_MEMORY_MB", DEFAULT_BUDGET_MB)) << 20)
@@ -0,0 +1,319 @@
+"""
+Map store shared by several server processes through memory-mapped files.
+
+When PATHFINDER_SHARED_MAPS names a directory (ideally on tmpfs, such as
+/dev/shm/pathfinder), `utils.map_store.map_store` is a SharedMapStore. It
+keeps every map version as a file there instead of in process memory. Each
+worker maps a version read-only once and gives the algorithms rows that are
+memoryview slices of that mapping. A grid is then held once in the page cache
+however many workers read it, and any worker can serve any map id. A worker's
+own memory grows only with its search state.
+
+Layout under the root directory:
+    <map_id>/current          version number of the live map
+    <map_id>/<version>.grid   MAGIC, format, rows, cols, then rows * cols cell bytes
+    <map_id>/lock             flock'd while a delta is being applied
+    <map_id>/pending          "<version> <pid>" while replace() prepares a version
+    <map_id>/atime            empty; its mtime is when any process last read the map
+
+Files are written under a temporary name and renamed into place, and
+`current` is replaced last, so readers only ever see complete versions.
+Superseded version files are unlinked; a process still searching one keeps
+its mapping until it lets go. POSIX only (flock, and unlinking mapped files).
+
+Beyond `max_maps` maps, storing one evicts the least recently read ones
+(by `atime`, touched at most once a second per map and process). Eviction
+takes the map's lock, skipping maps whose lock is held, and unlinks `current`
+first, so every process sees the map as gone before its files are removed.
+
+Derived tables are per process, and so is memory accounting: a mapped version
+is charged at its file size, and evicting it only unmaps it. A process that
+maps a newer version derives its tables from the version it had mapped before.
+replace() prepares the staged version's tables in the calling process before
+publishing it. Its `pending` file makes every process refuse deltas and report
+`pending_version` meanwhile; a file left by a process that has died is
+ignored.
+"""
+
+import fcntl
+import logging
+import mmap
+import os
+import shutil
+import struct
+import threading
+import time
+import uuid
+from collections import OrderedDict
+from contextlib import contextmanager
+from functools import partial
+
+from utils.files import write_atomic
+from utils.grid_utils import as_grid
+from utils.map_store import (MAX_MAPS, MapSnapshot, UnknownMapError, VersionConflictError,
+                             _apply_runs, _check_size, _validate_runs)
+from utils.residency import residency, GRID
+
+MAGIC = b"PFMP"
+FORMAT_VERSION = 1
+HEADER = struct.Struct("<4sIII")
+ATIME_INTERVAL_S = 1.0
+
+
+def map_grid_file(path):
+    """ Map a .grid file read-only; returns (rows, cols, grid of memoryview rows). """
+
+    with open(path, "rb") as f:
+        mapping = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    magic, fmt, rows, cols = HEADER.unpack_from(mapping)
+    if magic != MAGIC or fmt != FORMAT_VERSION or len(mapping) != HEADER.size + rows * cols:
+        raise ValueError(f"{path} is not a format {FORMAT_VERSION} map file.")
+    return rows, cols, as_grid(memoryview(mapping)[HEADER.size:], (rows, cols))
+
+
+class SharedMapStore:
+    """ MapStore interface over a directory of memory-mapped map versions (see module docstring). """
+
+    def __init__(self, root, max_maps=MAX_MAPS):
+        os.makedirs(root, exist_ok=True)
+        self.root = root
+        self.max_maps = max_maps
+        self._mapped = OrderedDict()   # map_id -> this process's snapshot of the live version
+        self._touched = OrderedDict()  # map_id -> time.monotonic() of this process's last atime touch
+        self._lock = threading.Lock()
+
+    def _dir(self, map_id):
+        # Ids are uuid hex, so nothing else names a map or reaches outside the root
+        if not isinstance(map_id, str) or not map_id.isalnum():
+            raise UnknownMapError(f"Unknown map '{map_id}'.")
+        return os.path.join(self.root, map_id)
+
+    def create(self, rows, cols, runs=()):
+        """ Store a new map and return its first snapshot (version 0). """
+
+        _check_size(rows, cols)
+        runs = list(runs)
+        _validate_runs(runs, rows * cols)
+        return self.store(rows, cols, _apply_runs([bytes(cols)] * rows, cols, runs))
+
+    def store(self, rows, cols, grid):
+        """ Store an already built grid (rows of bytes-like objects) as a new map at version 0. """
+
+        map_id = uuid.uuid4().hex
+        os.mkdir(self._dir(map_id))
+        open(os.path.join(self._dir(map_id), "atime"), "wb").close()
+        self._publish(map_id, rows, cols, 0, grid)
+        self._evict()
+        return self.get(map_id)
+
+    def get(self, map_id):
+        """ Current snapshot of `map_id`; raises UnknownMapError. """
+
+        while True:
+            version = self._current_version(map_id)
+            with self._lock:
+                snapshot = self._mapped.get(map_id)
+                hit = snapshot is not None and snapshot.version == version
+                if hit:
+                    self._mapped.move_to_end(map_id)
+                    residency.touch(map_id, GRID)
+            if hit:
+                self._touch(map_id)
+                return snapshot
+            try:
+                rows, cols, grid = map_grid_file(os.path.join(self._dir(map_id), f"{version}.grid"))
+            except FileNotFoundError:
+                # Superseded between reading `current` and opening the file
+                continue
+            with self._lock:
+                snapshot = MapSnapshot(map_id, rows, cols, version, grid, self._mapped.get(map_id))
+                self._mapped[map_id] = snapshot
+                while len(self._mapped) > self.max_maps:
+                    residency.release(self._mapped.popitem(last=False)[0])
+            residency.charge(map_id, GRID, HEADER.size + rows * cols, partial(self._unmap, snapshot))
+            self._touch(map_id)
+            return snapshot
+
+    def _touch(self, map_id):
+        # Record the read for eviction in every process, at most once per interval
+        now = time.monotonic()
+        with self._lock:
+            last = self._touched.get(map_id)
+            if last is not None and now - last < ATIME_INTERVAL_S:
+                return
+            self._touched[map_id] = now
+            self._touched.move_to_end(map_id)
+            while len(self._touched) > self.max_maps:
+                self._touched.popitem(last=False)
+        path = os.path.join(self._dir(map_id), "atime")
+        try:
+            os.utime(path)
+        except FileNotFoundError:
+            # Maps stored before atime files existed, or evicted meanwhile
+            try:
+                open(path, "ab").close()
+            except OSError:
+                pass
+
+    def _unmap(self, snapshot):
+        # Eviction callback; the file stays and is mapped again on the next get()
+        with self._lock:
+            if self._mapped.get(snapshot.map_id) is snapshot:
+                del self._mapped[snapshot.map_id]
+
+    def apply(self, map_id, base_version, runs):
+        """
+        Apply a delta made against `base_version` and return the new snapshot.
+        Raises UnknownMapError, VersionConflictError, or ValueError for bad runs.
+        """
+
+        with self._map_lock(map_id):
+            current = self._latest(map_id, base_version)
+            _validate_runs(runs, current.rows * current.cols)
+            grid = _apply_runs(current.grid, current.cols, runs)
+            self._publish(map_id, current.rows, current.cols, current.version + 1, grid)
+            os.unlink(os.path.join(self._dir(map_id), f"{current.version}.grid"))
+        return self.get(map_id)
+
+    def replace(self, map_id, base_version, rows, cols, runs):
+        """ Stage a whole new grid as the next version; see MapStore.replace. """
+
+        _check_size(rows, cols)
+        runs = list(runs)
+        _validate_runs(runs, rows * cols)
+        grid = _apply_runs([bytes(cols)] * rows, cols, runs)
+        with self._map_lock(map_id):
+            current = self._latest(map_id, base_version)
+            staged = MapSnapshot(map_id, rows, cols, current.version + 1, grid, current)
+            write_atomic(self._pending_path(map_id), [f"{staged.version} {os.getpid()}".encode()])
+        threading.Thread(target=self._prepare_and_swap, args=(staged, current.built_tables()),
+                         name=f"prepare-{map_id}", daemon=True).start()
+        return staged
+
+    def pending_version(self, map_id):
+        """ Version being prepared by replace() in any live process, or None. """
+
+        try:
+            with open(self._pending_path(map_id), "rb") as f:
+                version, pid = map(int, f.read().split())
+        except (FileNotFoundError, NotADirectoryError, ValueError):
+            return None
+        try:
+            os.kill(pid, 0)
+        except ProcessLookupError:
+            return None   # the preparing process died before swapping
+        except PermissionError:
+            pass
+        return version
+
+    def _pending_path(self, map_id):
+        return os.path.join(self._dir(map_id), "pending")
+
+    def _clear_pending(self, map_id, version):
+        # Caller holds the map lock
+        if self.pending_version(map_id) == version:
+            os.unlink(self._pending_path(map_id))
+
+    def _latest(self, map_id, base_version):
+        # The live snapshot a change may build on; caller holds the map lock
+        current = self.get(map_id)
+        staged = self.pending_version(map_id)
+        if staged is not None:
+            raise VersionConflictError(f"Version {staged} is still being prepared.")
+        if current.version != base_version:
+            raise VersionConflictError(
+                f"Delta is based on version {base_version}, map is at {current.version}.")
+        return current
+
+    def _prepare_and_swap(self, staged, names):
+        map_id = staged.map_id
+        try:
+            for name in names:
+                staged.table(name)
+            with self._map_lock(map_id):
+                current = self.get(map_id)
+                if current.version + 1 != staged.version:
+                    raise VersionConflictError(f"Map moved to version {current.version} meanwhile.")
+                self._publish(map_id, staged.rows, staged.cols, staged.version, staged.grid)
+                os.unlink(os.path.join(self._dir(map_id), f"{current.version}.grid"))
+                self._clear_pending(map_id, staged.version)
+                # Keep the prepared tables for the mapped copy of the new version
+                self.get(map_id).adopt_tables(staged)
+        except Exception:
+            logging.getLogger(__name__).exception("Replacing map %s failed", map_id)
+            try:
+                with self._map_lock(map_id):
+                    self._clear_pending(map_id, staged.version)
+            except UnknownMapError:
+                pass
+
+    def _current_version(self, map_id):
+        try:
+            with open(os.path.join(self._dir(map_id), "current"), "rb") as f:
+                return int(f.read())
+        except (FileNotFoundError, NotADirectoryError):
+            with self._lock:
+                self._mapped.pop(map_id, None)
+            residency.release(map_id)
+            raise UnknownMapError(f"Unknown map '{map_id}'.") from None
+
+    def _publish(self, map_id, rows, cols, version, grid):
+        directory = self._dir(map_id)
+        write_atomic(os.path.join(directory, f"{version}.grid"),
+                     [HEADER.pack(MAGIC, FORMAT_VERSION, rows, cols)] + list(grid))
+        write_atomic(os.path.join(directory, "current"), [str(version).encode()])
+
+    @contextmanager
+    def _map_lock(self, map_id):
+        directory = self._dir(map_id)
+        if not os.path.isdir(directory):
+            raise UnknownMapError(f"Unknown map '{map_id}'.")
+        with open(os.path.join(directory, "lock"), "a") as f:
+            fcntl.flock(f, fcntl.LOCK_EX)
+            try:
+                yield
+            finally:
+                fcntl.flock(f, fcntl.LOCK_UN)
+
+    def _last_read(self, map_id):
+        # mtime of `atime`, or of `current` for maps without one; None once gone
+        for name in ("atime", "current"):
+            try:
+                return os.stat(os.path.join(self.root, map_id, name)).st_mtime
+            except OSError:
+                continue
+        return None
+
+    def _evict(self):
+        # Least recently read maps beyond the limit, across all processes
+        entries = []
+        for map_id in os.listdir(self.root):
+            last_read = self._last_read(map_id)
+            if last_read is not None:
+                entries.append((last_read, map_id))
+        entries.sort()
+        for _, map_id in entries[:max(0, len(entries) - self.max_maps)]:
+            self._remove(map_id)
+
+    def _remove(self, map_id):
+        directory = os.path.join(self.root, map_id)
+        try:
+            f = open(os.path.join(directory, "lock"), "a")
+        except OSError:
+            return
+        with f:
+            try:
+                fcntl.flock(f, fcntl.LOCK_EX | fcntl.LOCK_NB)
+            except BlockingIOError:
+                return   # a delta or replace is running: the map is in use
+            try:
+                # Without `current` every process reports the map unknown; any
+                # still searching a version keep their mappings of its unlinked file
+                os.unlink(os.path.join(directory, "current"))
+            except FileNotFoundError:
+                return   # removed by another process
+            shutil.rmtree(directory, ignore_errors=True)
+        with self._lock:
+            self._mapped.pop(map_id, None)
+            self._touched.pop(map_id, None)
+        residency.release(map_id)
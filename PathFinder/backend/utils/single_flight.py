@@ -0,0 +1,79 @@
+"""
+Single-flight coalescing of identical concurrent requests.
+
+When many clients send the same request at once (a class all running the
+default map, say), only the first one computes the response. The others wait
+for it and receive the same pre-encoded bytes. Nothing is cached: once the
+first caller finishes, the next identical request computes afresh.
+"""
+
+import copy
+import hashlib
+import threading
+
+
+def content_key(*parts):
+    """ SHA-256 hex digest over `parts` (bytes, or anything str() describes exactly). """
+
+    digest = hashlib.sha256()
+    for part in parts:
+        data = part if isinstance(part, (bytes, bytearray)) else str(part).encode()
+        # Length-prefixed so ("ab", "c") and ("a", "bc") differ
+        digest.update(len(data).to_bytes(8, "little"))
+        digest.update(data)
+    return digest.hexdigest()
+
+
+class _Call:
+    def __init__(self):
+        self.done = threading.Event()
+        self.result = None
+        self.error = None
+
+
+class SingleFlight:
+    """ Runs each key's function once among the callers that overlap in time. """
+
+    def __init__(self):
+        self._calls = {}
+        self._lock = threading.Lock()
+        self.leaders = 0    # calls that ran the function
+        self.shared = 0     # calls that received a leader's result instead
+
+    def do(self, key, fn):
+        """
+        Return fn() for the first caller with `key`; callers arriving while it
+        runs wait and get the same result, or the same exception raised.
+        """
+
+        with self._lock:
+            call = self._calls.get(key)
+            leader = call is None
+            if leader:
+                call = self._calls[key] = _Call()
+                self.leaders += 1
+            else:
+                self.shared += 1
+
+        if not leader:
+            call.done.wait()
+        else:
+            try:
+                call.result = fn()
+            except Exception as e:
+                call.error = e
+            finally:
+                with self._lock:
+                    del self._calls[key]
+                call.done.set()
+
+        if call.error is not None:
+            # Waiters raise a copy, so tracebacks do not pile up on one shared object
+            raise call.error if leader else copy.copy(call.error)
+        return call.result
+
+    def stats(self):
+        """ {"in_flight", "leaders", "shared"} counters. """
+
+        with self._lock:
+            return {"in_flight": len(self._calls), "leaders": self.leaders, "shared": self.shared}
@@ -0,0 +1,217 @@
+"""
+On-disk cache of derived tables, keyed by map content.
+
+A derived table (utils/derived.py) depends only on the cells of the map it was
+built from. When PATHFINDER_TABLE_CACHE names a directory, each table that
+took a while to build is written there under the SHA-256 of its map's content.
+A restarted server, another worker process, or a fresh upload of the same map
+then loads it instead of building it again. Cheap tables, such as a graph
+patched for a small edit, are not written.
+
+File name: <content hash>.<table name>.tbl. Layout (native byte order):
+
+    header    magic "PFDT", format u16, byte-order mark u16 (0xFEFF),
+              codec version u16, section count u16, CRC-32 u32, payload bytes u64
+    sections  per section: array typecode (1 byte, 7 bytes padding), byte length u64
+    payload   the sections' items, each section padded to 8 bytes
+
+The CRC covers the section table and the payload. Sections are aligned so a
+mapped file can be read in place through memoryview casts. A file with a
+different format, byte order or codec version, or a bad checksum, counts as a
+miss (and the bad file is removed). Least recently used files are removed once
+the directory grows past PATHFINDER_TABLE_CACHE_MB (default 1024).
+"""
+
+import hashlib
+import logging
+import mmap
+import os
+import struct
+import threading
+import zlib
+
+from utils.derived import TABLE_CODECS
+from utils.files import write_atomic
+
+MAGIC = b"PFDT"
+FORMAT_VERSION = 1
+BYTE_ORDER_MARK = 0xFEFF
+HEADER = struct.Struct("=4sHHHHIQ")
+SECTION = struct.Struct("=c7xQ")
+DEFAULT_MAX_MB = 1024
+# Builds faster than this are cheaper to repeat than to store
+MIN_BUILD_MS = 50.0
+
+log = logging.getLogger(__name__)
+
+
+def content_hash(rows, cols, grid):
+    """ SHA-256 hex digest of a map's shape and cells (any bytes-like rows). """
+
+    digest = hashlib.sha256(struct.pack("<II", rows, cols))
+    for row in grid:
+        digest.update(row if isinstance(row, (bytes, bytearray, memoryview)) else bytes(row))
+    return digest.hexdigest()
+
+
+def _padded(n):
+    return (n + 7) & ~7
+
+
+def encode_sections(codec_version, sections):
+    """ Header and body chunks of a cache file holding `sections` (array.array objects). """
+
+    table = bytearray()
+    payload = bytearray()
+    for section in sections:
+        data = section.tobytes()
+        table += SECTION.pack(section.typecode.encode(), len(data))
+        payload += data + bytes(_padded(len(data)) - len(data))
+    body = bytes(table + payload)
+    header = HEADER.pack(MAGIC, FORMAT_VERSION, BYTE_ORDER_MARK, codec_version, len(sections),
+                         zlib.crc32(body), len(body))
+    return [header, body]
+
+
+def decode_sections(buffer, codec_version):
+    """ Typed memoryviews over the sections of a cache file in `buffer`; raises ValueError. """
+
+    if len(buffer) < HEADER.size:
+        raise ValueError("truncated header")
+    magic, fmt, bom, version, count, crc, size = HEADER.unpack_from(buffer)
+    if magic != MAGIC or fmt != FORMAT_VERSION or bom != BYTE_ORDER_MARK:
+        raise ValueError(f"not a format {FORMAT_VERSION} table file for this byte order")
+    if version != codec_version:
+        raise ValueError(f"codec version {version}, expected {codec_version}")
+    view = memoryview(buffer)[HEADER.size:]
+    if len(view) != size or zlib.crc32(view) != crc:
+        raise ValueError("checksum mismatch")
+
+    sections = []
+    pos = count * SECTION.size
+    for i in range(count):
+        typecode, length = SECTION.unpack_from(view, i * SECTION.size)
+        sections.append(view[pos:pos + length].cast(typecode.decode()))
+        pos += _padded(length)
+    return sections
+
+
+class TableCache:
+    """ Directory of cached derived tables (see module docstring). """
+
+    def __init__(self, root, max_bytes=DEFAULT_MAX_MB << 20):
+        os.makedirs(root, exist_ok=True)
+        self.root = root
+        self.max_bytes = max_bytes
+        self._lock = threading.Lock()
+        self._counts = {"hits": 0, "misses": 0, "writes": 0, "errors": 0}
+
+    def _path(self, key, name):
+        return os.path.join(self.root, f"{key}.{name}.tbl")
+
+    def _count(self, field):
+        with self._lock:
+            self._counts[field] += 1
+
+    def load(self, name, snapshot):
+        """ Table `name` for `snapshot` from disk, or None on a miss. """
+
+        codec = TABLE_CODECS.get(name)
+        if codec is None:
+            return None
+        version, _, decode = codec
+        path = self._path(snapshot.content_hash(), name)
+        try:
+            with open(path, "rb") as f:
+                mapping = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except (FileNotFoundError, ValueError):
+            # ValueError: an empty file cannot be mapped
+            self._count("misses")
+            return None
+
+        # The mapping is released once the decoded table no longer views it
+        try:
+            table = decode(snapshot, decode_sections(mapping, version))
+        except ValueError as e:
+            log.warning("Discarding cached table %s: %s", path, e)
+            self._count("errors")
+            self._remove(path)
+            return None
+
+        try:
+            os.utime(path)
+        except OSError:
+            pass
+        self._count("hits")
+        return table
+
+    def save(self, name, snapshot, table):
+        """ Write `table` for `snapshot`; failures are logged, never raised. """
+
+        codec = TABLE_CODECS.get(name)
+        if codec is None:
+            return
+        version, encode, _ = codec
+        try:
+            write_atomic(self._path(snapshot.content_hash(), name), encode_sections(version, encode(table)))
+            self._count("writes")
+            self._evict()
+        except OSError:
+            log.exception("Writing cached table %s failed", name)
+            self._count("errors")
+
+    def maybe_save(self, name, snapshot, table, build_ms):
+        """ save() a freshly built table if it was slow enough to be worth keeping. """
+
+        if build_ms >= MIN_BUILD_MS:
+            self.save(name, snapshot, table)
+
+    def stats(self):
+        """ {"hits", "misses", "writes", "errors", "files", "bytes", "max_bytes"}. """
+
+        files = self._files()
+        with self._lock:
+            return {
+                **self._counts,
+                "files": len(files),
+                "bytes": sum(size for _, size, _ in files),
+                "max_bytes": self.max_bytes,
+            }
+
+    def _files(self):
+        files = []
+        for entry in os.scandir(self.root):
+            if entry.name.endswith(".tbl"):
+                try:
+                    stat = entry.stat()
+                except OSError:
+                    continue
+                files.append((stat.st_mtime, stat.st_size, entry.path))
+        return files
+
+    def _remove(self, path):
+        try:
+            os.unlink(path)
+        except OSError:
+            pass
+
+    def _evict(self):
+        # Least recently used first (loads refresh the mtime)
+        files = sorted(self._files())
+        total = sum(size for _, size, _ in files)
+        for _, size, path in files:
+            if total <= self.max_bytes:
+                break
+            self._remove(path)
+            total -= size
+
+
+def _default_cache():
+    root = os.environ.get("PATHFINDER_TABLE_CACHE")
+    if not root:
+        return None
+    return TableCache(root, int(os.environ.get("PATHFINDER_TABLE_CACHE_MB", DEFAULT_MAX_MB)) << 20)
+
+
+# Shared by the map stores; None when the cache is off
+table_cache = _default_cache()
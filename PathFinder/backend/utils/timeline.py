@@ -0,0 +1,118 @@
+"""
+Per-request timelines in Chrome trace-event format.
+
+A request opts in with the header `X-Timeline: 1`. Its handler then records a
+span for each phase: parse, validate, cache lookup, preprocessing, admission
+wait, search (with path reconstruction nested inside it, recorded by the
+algorithms), serialization and response write. The finished timeline is kept
+under an id, which the response returns in `X-Timeline-Id`. GET
+/api/timelines/<id> serves it as trace-event JSON, which chrome://tracing and
+Perfetto can open. The frontend merges these events with its own worker and
+animation phases into one file (frontend/js/timeline.js).
+
+Spans are recorded on the thread that handles the request, through `span()`.
+It costs one thread-local lookup when no timeline is active, so it can stay
+in code every request runs.
+"""
+
+import threading
+import time
+import uuid
+from collections import OrderedDict
+from contextlib import contextmanager
+
+MAX_TIMELINES = 256
+SERVER_PID = 3   # the browser side uses 1 (page) and 2 (worker)
+
+_local = threading.local()
+
+
+class RequestTimeline:
+    """ Spans of one request, in microseconds since the timeline started. """
+
+    def __init__(self, name):
+        self.timeline_id = uuid.uuid4().hex
+        self.name = name
+        self.events = []
+        self._t0 = time.perf_counter()
+
+    def _us(self, t):
+        return round(1e6 * (t - self._t0), 1)
+
+    def add(self, name, started, ended, args=None):
+        event = {"name": name, "cat": "server", "ph": "X", "ts": self._us(started),
+                 "dur": round(1e6 * (ended - started), 1),
+                 "pid": SERVER_PID, "tid": threading.get_ident() % 100_000}
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+    @contextmanager
+    def span(self, name, **args):
+        started = time.perf_counter()
+        try:
+            yield
+        finally:
+            self.add(name, started, time.perf_counter(), args)
+
+    def chrome_trace(self):
+        """ {"traceEvents": [...]} with process and thread names. """
+
+        threads = {event["tid"] for event in self.events}
+        meta = [{"name": "process_name", "ph": "M", "pid": SERVER_PID, "args": {"name": "server"}}]
+        meta += [{"name": "thread_name", "ph": "M", "pid": SERVER_PID, "tid": tid,
+                  "args": {"name": f"request thread {tid}"}} for tid in sorted(threads)]
+        return {"traceEvents": meta + self.events, "otherData": {"request": self.name}}
+
+
+@contextmanager
+def span(name, **args):
+    """ Record `name` on the current request's timeline, if it has one. """
+
+    timeline = getattr(_local, "timeline", None)
+    if timeline is None:
+        yield
+        return
+    with timeline.span(name, **args):
+        yield
+
+
+def begin(name):
+    """ Start a timeline for the request on this thread and return it. """
+
+    timeline = RequestTimeline(name)
+    _local.timeline = timeline
+    return timeline
+
+
+def end():
+    """ Detach the current timeline from this thread and keep it for GET /api/timelines. """
+
+    timeline = getattr(_local, "timeline", None)
+    _local.timeline = None
+    if timeline is not None:
+        timelines.put(timeline)
+    return timeline
+
+
+class TimelineStore:
+    """ The most recent finished timelines, by id. """
+
+    def __init__(self, max_timelines=MAX_TIMELINES):
+        self.max_timelines = max_timelines
+        self._timelines = OrderedDict()
+        self._lock = threading.Lock()
+
+    def put(self, timeline):
+        with self._lock:
+            self._timelines[timeline.timeline_id] = timeline
+            while len(self._timelines) > self.max_timelines:
+                self._timelines.popitem(last=False)
+
+    def get(self, timeline_id):
+        with self._lock:
+            return self._timelines.get(timeline_id)
+
+
+# Shared by the request handlers
+timelines = TimelineStore()
@@ -0,0 +1,122 @@
+"""
+Exploration trace recording for the search algorithms.
+
+A SearchTrace decides how much of a search's exploration is kept for the
+response. The algorithms ask it once for a `visit` callback before their main
+loop and only call that callback per expansion when it is not None, so a
+`none` trace costs the hot loop a single local test and no allocations.
+
+Levels:
+    none      path only, nothing recorded
+    sampled   every k-th expansion
+    frontier  a snapshot of the open list every k expansions
+    full      every expansion, in order (the historical behaviour)
+
+Independently of the level, `record=True` also captures every expansion and
+push with its g/f values in a TraceRecorder for binary trace files
+(see utils/trace_file.py), and `progress` is called with the expansion count
+every `progress_every` expansions (used by queued jobs, see utils/jobs.py).
+"""
+
+from utils.trace_file import TraceRecorder
+
+TRACE_LEVELS = ("none", "sampled", "frontier", "full")
+DEFAULT_SAMPLE_EVERY = 10
+DEFAULT_PROGRESS_EVERY = 5000
+
+
+class SearchTrace:
+    def __init__(self, level="full", every=DEFAULT_SAMPLE_EVERY, record=False,
+                 progress=None, progress_every=DEFAULT_PROGRESS_EVERY):
+        if level not in TRACE_LEVELS:
+            raise ValueError(f"Invalid trace level '{level}'. Supported: {TRACE_LEVELS}.")
+        if not isinstance(every, int) or every < 1:
+            raise ValueError("Trace sample interval must be a positive integer.")
+        self.level = level
+        self.every = every
+        self.visited = []
+        self.frontier = []   # [[expansion index, [[r, c], ...]], ...]
+        self._watched = []
+        self.recorder = TraceRecorder() if record else None
+        self.progress = progress
+        self.progress_every = progress_every
+
+    def watch(self, *containers, node_of=list):
+        """
+        Register the algorithm's open list(s) for frontier snapshots. `node_of`
+        turns one container entry into the [row, col] cell it refers to.
+        """
+
+        if self.level == "frontier":
+            self._watched.extend((container, node_of) for container in containers)
+
+    def visitor(self):
+        """
+        Return the per-expansion callback `visit(node, g=None, f=None)`, or None
+        when nothing is recorded.
+        """
+
+        visit = self._level_visitor()
+        if self.recorder is not None:
+            visit = self._and_record(visit)
+        if self.progress is not None:
+            visit = self._and_report(visit)
+        return visit
+
+    def _and_record(self, visit):
+        expand = self.recorder.expand
+        if visit is None:
+            return expand
+
+        def visit_and_record(node, g=None, f=None):
+            visit(node)
+            expand(node, g, f)
+        return visit_and_record
+
+    def _and_report(self, visit):
+        report = self.progress
+        every = self.progress_every
+        counter = [0]
+
+        def visit_and_report(node, g=None, f=None):
+            if visit is not None:
+                visit(node, g, f)
+            counter[0] += 1
+            if counter[0] % every == 0:
+                report(counter[0])
+        return visit_and_report
+
+    def pusher(self):
+        """ Return the per-push callback `push(node, g=None, f=None)`, or None when not recording. """
+
+        return self.recorder.push if self.recorder is not None else None
+
+    def _level_visitor(self):
+        if self.level == "none":
+            return None
+
+        append = self.visited.append
+        if self.level == "full":
+            def visit(node, g=None, f=None):
+                append(list(node))
+            return visit
+
+        every = self.every
+        counter = [0]
+        if self.level == "sampled":
+            def visit(node, g=None, f=None):
+                counter[0] += 1
+                if counter[0] % every == 1 or every == 1:
+                    append(list(node))
+            return visit
+
+        watched = self._watched
+        snapshots = self.frontier
+
+        def visit(node, g=None, f=None):
+            counter[0] += 1
+            if counter[0] % every == 1 or every == 1:
+                snapshots.append([counter[0] - 1, [node_of(item)
+                                                   for container, node_of in watched
+                                                   for item in container]])
+        return visit
@@ -0,0 +1,232 @@
+"""
+Compact binary exploration traces for offline replay.
+
+A trace file stores one search run: the grid it ran on, the ordered stream of
+expand/push events with their g and f values, and the final path. Events are
+stored column by column so each column compresses on its own terms:
+
+    kinds   1 bit per event (0 = expand, 1 = push), packed LSB first
+    cells   cell index (row * cols + col), zigzag varint of the delta to the previous event
+    g, f    cost * cost_scale rounded to an int, zigzag varint of the delta
+            (cost_scale is 1 when every cost is integral, else COST_SCALE)
+    path    cell indices, zigzag varint deltas
+    walls   1 bit per cell, row-major, packed LSB first
+    extents only with FLAG_HAS_EXTENTS: height and width of each event's cell
+            block (1, 1 for plain cells), interleaved, zigzag varint deltas
+    present only with FLAG_HAS_MISSING_COSTS: 1 bit per event for g, then 1
+            bit per event for f, packed LSB first; a clear bit marks a cost
+            the search did not report (its g/f delta is 0)
+
+Header (little endian):
+    magic "PFTR", version u8, flags u8, rows u32, cols u32, start u32, end u32,
+    events u32, path length u32, cost_scale u32, then the byte length (u32) of
+    each column in the order walls, kinds, cells, g, f, path. With
+    FLAG_HAS_EXTENTS the path column is followed by the extents column's byte
+    length (u32) and the column itself. The same goes for the present column
+    with FLAG_HAS_MISSING_COSTS, after the extents if both are written.
+
+Extents are written when the search reports [row, col, height, width] blocks
+(block A*), so replay can show the blocks rather than their origin cells.
+The present column is written when some events have costs and others do not
+(block A* expansions carry f but no g), so those decode as None again.
+
+The frontend decoder lives in `frontend/js/trace.js`; keep the two in sync.
+"""
+
+import struct
+
+MAGIC = b"PFTR"
+VERSION = 1
+FLAG_HAS_COSTS = 1
+FLAG_HAS_EXTENTS = 2
+FLAG_HAS_MISSING_COSTS = 4
+COST_SCALE = 1000
+
+_HEADER = struct.Struct("<4sBBIIIIIII6I")
+_LENGTH = struct.Struct("<I")
+
+EXPAND = 0
+PUSH = 1
+
+
+class TraceRecorder:
+    """ Collects expand/push events from a running search. """
+
+    def __init__(self):
+        self.kinds = bytearray()
+        self.nodes = []
+        self.g = []
+        self.f = []
+
+    def expand(self, node, g=None, f=None):
+        self.kinds.append(EXPAND)
+        self.nodes.append(node)
+        self.g.append(g)
+        self.f.append(f)
+
+    def push(self, node, g=None, f=None):
+        self.kinds.append(PUSH)
+        self.nodes.append(node)
+        self.g.append(g)
+        self.f.append(f)
+
+
+def _write_varint(out, value):
+    # Zigzag first so small negative deltas stay small
+    value = (value << 1) ^ (value >> 63)
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def _read_varints(data, count):
+    values = []
+    append = values.append
+    pos = 0
+    prev = 0
+    for _ in range(count):
+        shift = 0
+        raw = 0
+        while True:
+            byte = data[pos]
+            pos += 1
+            raw |= (byte & 0x7F) << shift
+            if byte < 0x80:
+                break
+            shift += 7
+        prev += (raw >> 1) ^ -(raw & 1)
+        append(prev)
+    return values
+
+
+def _delta_column(values):
+    out = bytearray()
+    prev = 0
+    for value in values:
+        _write_varint(out, value - prev)
+        prev = value
+    return out
+
+
+def _pack_bits(bits):
+    out = bytearray((len(bits) + 7) // 8)
+    for i, bit in enumerate(bits):
+        if bit:
+            out[i >> 3] |= 1 << (i & 7)
+    return out
+
+
+def _unpack_bits(data, count):
+    return [(data[i >> 3] >> (i & 7)) & 1 for i in range(count)]
+
+
+def encode_trace(grid, start, end, recorder, path):
+    """ Serialize a recorded search on `grid` to trace-file bytes. """
+
+    rows = len(grid)
+    cols = len(grid[0]) if rows > 0 else 0
+
+    costs = [v for v in recorder.g + recorder.f if v is not None]
+    has_costs = bool(costs)
+    scale = 1 if all(v == int(v) for v in costs) else COST_SCALE
+
+    def scaled(values):
+        # Missing values repeat the previous one, so their deltas cost a byte
+        out = []
+        prev = 0
+        for v in values:
+            if v is not None:
+                prev = int(round(v * scale))
+            out.append(prev)
+        return out
+
+    walls = _pack_bits([cell == 1 for row in grid for cell in row])
+    kinds = _pack_bits(recorder.kinds)
+    cells = _delta_column([node[0] * cols + node[1] for node in recorder.nodes])
+    g_col = _delta_column(scaled(recorder.g)) if has_costs else b""
+    f_col = _delta_column(scaled(recorder.f)) if has_costs else b""
+    path_col = _delta_column([r * cols + c for r, c in path])
+    has_extents = any(len(node) == 4 for node in recorder.nodes)
+    has_missing = has_costs and len(costs) < len(recorder.g) + len(recorder.f)
+
+    columns = [walls, kinds, cells, g_col, f_col, path_col]
+    flags = ((FLAG_HAS_COSTS if has_costs else 0) | (FLAG_HAS_EXTENTS if has_extents else 0)
+             | (FLAG_HAS_MISSING_COSTS if has_missing else 0))
+    header = _HEADER.pack(
+        MAGIC, VERSION, flags,
+        rows, cols, start[0] * cols + start[1], end[0] * cols + end[1],
+        len(recorder.kinds), len(path), scale,
+        *[len(col) for col in columns])
+    parts = [header] + [bytes(col) for col in columns]
+    if has_extents:
+        extents = _delta_column([v for node in recorder.nodes
+                                 for v in (node[2:4] if len(node) == 4 else (1, 1))])
+        parts += [_LENGTH.pack(len(extents)), bytes(extents)]
+    if has_missing:
+        present = _pack_bits([v is not None for v in recorder.g + recorder.f])
+        parts += [_LENGTH.pack(len(present)), bytes(present)]
+    return b"".join(parts)
+
+
+def decode_trace(data):
+    """
+    Parse trace-file bytes into a dict with grid, start, end, events
+    ([kind, row, col, g, f] with g/f None when not recorded, followed by
+    height and width when the trace has extents) and path.
+    """
+
+    fields = _HEADER.unpack_from(data, 0)
+    magic, version, flags, rows, cols, start, end, n_events, n_path, scale = fields[:10]
+    if magic != MAGIC:
+        raise ValueError("Not a PathFinder trace file.")
+    if version != VERSION:
+        raise ValueError(f"Unsupported trace version {version}.")
+
+    columns = []
+    pos = _HEADER.size
+    for length in fields[10:]:
+        columns.append(memoryview(data)[pos:pos + length])
+        pos += length
+    walls, kinds, cells, g_col, f_col, path_col = columns
+
+    wall_bits = _unpack_bits(walls, rows * cols)
+    grid = [wall_bits[r * cols:(r + 1) * cols] for r in range(rows)]
+    kind_list = _unpack_bits(kinds, n_events)
+    cell_list = _read_varints(cells, n_events)
+    if flags & FLAG_HAS_COSTS:
+        g_list = [v / scale for v in _read_varints(g_col, n_events)]
+        f_list = [v / scale for v in _read_varints(f_col, n_events)]
+    else:
+        g_list = f_list = [None] * n_events
+
+    events = [[k, idx // cols, idx % cols, g, f]
+              for k, idx, g, f in zip(kind_list, cell_list, g_list, f_list)]
+
+    # Optional columns after the path, each preceded by its byte length
+    def trailing(pos):
+        length, = _LENGTH.unpack_from(data, pos)
+        pos += _LENGTH.size
+        return memoryview(data)[pos:pos + length], pos + length
+
+    if flags & FLAG_HAS_EXTENTS:
+        extents_col, pos = trailing(pos)
+        extents = _read_varints(extents_col, 2 * n_events)
+        for i, event in enumerate(events):
+            event += extents[2 * i:2 * i + 2]
+    if flags & FLAG_HAS_MISSING_COSTS:
+        present_col, pos = trailing(pos)
+        present = _unpack_bits(present_col, 2 * n_events)
+        for i, event in enumerate(events):
+            if not present[i]:
+                event[3] = None
+            if not present[n_events + i]:
+                event[4] = None
+    path = [[idx // cols, idx % cols] for idx in _read_varints(path_col, n_path)]
+    return {
+        "grid": grid,
+        "start": [start // cols, start % cols],
+        "end": [end // cols, end % cols],
+        "events": events,
+        "path": path,
+    }
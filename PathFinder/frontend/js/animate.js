@@ -1,56 +1,159 @@
 // Animates the search process: visited nodes then final path
+// Painting goes through the grid model; the grid view redraws what changed.
+
+import { getModel } from './grid.js';
+import { nowUs } from './timeline.js';
 
 const VISIT_DELAY = 20; // ms per visited node
 const PATH_DELAY = 50;  // ms per path node
 
+// The running animation, if any: { visited, path, cols, extents, frontier,
+// explored, index, timer, resolve, onProgress, timeline, phaseStarted }, where
+// `explored` counts the exploration steps (visited entries or frontier snapshots)
+let active = null;
+
+// Entries are [row, col] / [row, col, height, width] arrays, or row-major cell
+// indices when the list is a typed array (decoded trace files), with their
+// heights and widths interleaved in `extents` for block traces
+function entryAt(list, i, cols, extents = null) {
+  if (ArrayBuffer.isView(list)) {
+    const r = Math.floor(list[i] / cols);
+    const c = list[i] % cols;
+    return extents ? [r, c, extents[2 * i], extents[2 * i + 1]] : [r, c];
+  }
+  return list[i];
+}
+
+// [row, col, height, width] entries mark a whole block at once
+function paintVisited([r, c, h = 1, w = 1]) {
+  getModel().markVisited(r, c, h, w);
+}
+
+function paintPath([r, c]) {
+  getModel().markPath(r, c);
+}
+
+// Frontier snapshot s: cells that left the open list since snapshot s - 1 were
+// expanded, so they turn visited, and the current open list is drawn on top
+function paintFrontier({ offsets, cells }, s, cols) {
+  const model = getModel();
+  for (let k = s > 0 ? offsets[s - 1] : 0; k < offsets[s]; k++) {
+    model.markVisited(Math.floor(cells[k] / cols), cells[k] % cols);
+  }
+  for (let k = offsets[s]; k < offsets[s + 1]; k++) {
+    model.markFrontier(Math.floor(cells[k] / cols), cells[k] % cols);
+  }
+}
+
+function paintExplored(a, i) {
+  if (a.frontier) {
+    paintFrontier(a.frontier, i, a.cols);
+  } else {
+    paintVisited(entryAt(a.visited, i, a.cols, a.extents));
+  }
+}
+
+// Close the current phase's span on the animation's timeline, if it has one
+function endPhase(a, name) {
+  if (!a.timeline) return;
+  const now = nowUs();
+  a.timeline.span(name, a.phaseStarted, now);
+  a.phaseStarted = now;
+}
+
+function finish() {
+  const { resolve } = active;
+  endPhase(active, active.index > active.explored ? 'animate path' : 'animate visited');
+  clearTimeout(active.timer);
+  active = null;
+  document.getElementById('grid').classList.remove('animating');
+  resolve();
+}
+
+function step() {
+  const a = active;
+  const total = a.explored + a.path.length;
+  if (a.index < a.explored) {
+    paintExplored(a, a.index);
+    a.index++;
+    a.timer = setTimeout(step, a.index < a.explored ? VISIT_DELAY : 0);
+  } else if (a.index < total) {
+    if (a.index === a.explored) endPhase(a, 'animate visited');
+    paintPath(entryAt(a.path, a.index - a.explored, a.cols));
+    a.index++;
+    a.timer = setTimeout(step, PATH_DELAY);
+  } else {
+    finish();
+    return;
+  }
+  if (a.onProgress) a.onProgress(a.index, total);
+}
+
 /**
  * Animate visited nodes and then the final path on the grid.
  *
- * @param {Array<[number, number]>} visited List of [row, col] visited in order
- * @param {Array<[number, number]>} path List of [row, col] forming the final path
+ * @param {Array<number[]>|Int32Array} visited List of [row, col] (or [row, col, height, width] blocks)
+ *   visited in order, or a typed array of row-major cell indices
+ * @param {Array<[number, number]>|Int32Array} path List of [row, col] forming the final path,
+ *   or a typed array of row-major cell indices
+ * @param {{ cols?: number, startAt?: number, onProgress?: (step: number, total: number) => void }} [options]
+ *   `cols` is required for typed-array input; `startAt` skips ahead like seekAnimation()
+ * @param {Int32Array} [options.extents] Height and width of each typed-array visited entry, interleaved
+ * @param {{ at: Int32Array, offsets: Int32Array, cells: Int32Array }} [options.frontier] Open-list
+ *   snapshots (see flattenFrontier() in js/grid_worker.js), replayed one per step instead of `visited`
+ * @param {import('./timeline.js').Timeline} [options.timeline] Records the visited and path phases
  * @returns {Promise<void>} Resolves when animation is complete
  */
-export function animateSearch(visited, path) {
+export function animateSearch(visited, path, {
+  cols = 0, extents = null, frontier = null, startAt = 0, onProgress = null, timeline = null,
+} = {}) {
+  if (active) finish();
   return new Promise((resolve) => {
-    const gridContainer = document.getElementById('grid');
-    gridContainer.classList.add('animating');
-
-    // Animate visited nodes
-    visited.forEach(([r, c], i) => {
-      setTimeout(() => {
-        const cell = document.querySelector(`.cell[data-row='${r}'][data-col='${c}']`);
-        if (cell && !cell.classList.contains('start') && !cell.classList.contains('end')) {
-          cell.classList.add('visited');
-        }
-      }, VISIT_DELAY * i);
-    });
-
-    // After visited animation, animate path
-    const totalVisitTime = VISIT_DELAY * visited.length;
-    path.forEach(([r, c], i) => {
-      setTimeout(() => {
-        const cell = document.querySelector(`.cell[data-row='${r}'][data-col='${c}']`);
-        if (cell && !cell.classList.contains('start') && !cell.classList.contains('end')) {
-          cell.classList.remove('visited');
-          cell.classList.add('path');
-        }
-        // Resolve when last path node is rendered
-        if (i === path.length - 1) {
-          const doneCleanup = () => {
-            gridContainer.classList.remove('animating');
-            resolve();
-          };
-          setTimeout(doneCleanup, PATH_DELAY);
-        }
-      }, totalVisitTime + PATH_DELAY * i);
-    });
-
-    // If no path, still remove animating class after visits
-    if (path.length === 0) {
-      setTimeout(() => {
-        gridContainer.classList.remove('animating');
-        resolve();
-      }, totalVisitTime);
+    document.getElementById('grid').classList.add('animating');
+    active = {
+      visited,
+      path,
+      cols,
+      extents,
+      frontier,
+      explored: frontier ? frontier.at.length : visited.length,
+      index: 0,
+      timer: null,
+      resolve,
+      onProgress,
+      timeline,
+      phaseStarted: nowUs(),
+    };
+    if (startAt > 0) {
+      seekAnimation(startAt);
+    } else {
+      step();
     }
   });
 }
+
+/**
+ * Jump the running animation to `target` steps (visited entries or frontier
+ * snapshots first, then path entries), repainting the grid to match, and
+ * continue playing from there.
+ *
+ * @param {number} target Step index in [0, exploration steps + path.length]
+ */
+export function seekAnimation(target) {
+  const a = active;
+  if (!a) return;
+  const total = a.explored + a.path.length;
+  target = Math.max(0, Math.min(target, total));
+
+  getModel().clearOverlay();
+  const exploredUpTo = Math.min(target, a.explored);
+  for (let i = 0; i < exploredUpTo; i++) paintExplored(a, i);
+  for (let i = a.explored; i < target; i++) {
+    paintPath(entryAt(a.path, i - a.explored, a.cols));
+  }
+
+  a.index = target;
+  clearTimeout(a.timer);
+  a.timer = setTimeout(step, VISIT_DELAY);
+  if (a.onProgress) a.onProgress(a.index, total);
+}
@@ -1,23 +1,81 @@
+import { LOCAL_ALGORITHMS, packGrid, solveLocal } from './local_engine.js';
+import { nowUs } from './timeline.js';
+
 const BASE_URL = 'http://localhost:5000';
 
+// Grids up to this many cells are solved in the browser when the algorithm and
+// trace level allow it; larger maps still go to the server.
+const LOCAL_MAX_CELLS = 400 * 400;
+const LOCAL_TRACE_LEVELS = ['none', 'full'];
+
+/**
+ * Whether solve() would run this request in the browser rather than on the server.
+ *
+ * @param {number} rows
+ * @param {number} cols
+ * @param {string} algorithm
+ * @param {{ trace?: string, local?: boolean }} [options]
+ * @returns {boolean}
+ */
+export function canSolveLocally(rows, cols, algorithm, options = {}) {
+  return options.local !== false
+    && LOCAL_ALGORITHMS.includes(algorithm)
+    && LOCAL_TRACE_LEVELS.includes(options.trace || 'full')
+    && rows * cols <= LOCAL_MAX_CELLS;
+}
+
 /**
- * Send the grid, start/end points, and chosen algorithm to the server
- * and return the exploration order and final path.
+ * Solve the grid and return the exploration order and final path. Runs in the
+ * browser (js/local_engine.js) when possible, otherwise on the server; both
+ * return identical results.
  *
  * @param {number[][]} grid 2D array (0 = empty, 1 = wall)
  * @param {[number, number]} start [row, col] of the start cell
  * @param {[number, number]} end [row, col] of the end cell
  * @param {string} algorithm One of: 'bfs', 'dfs', 'dijkstra', 'astar', 'bidirectional'
- * @returns {Promise<{ visited: Array<[number, number]>, path: Array<[number, number]> }>} 
+ * @param {{ trace?: 'none'|'sampled'|'frontier'|'full', sampleEvery?: number, local?: boolean }} [options]
+ *   How much of the exploration to return (default 'full'); `local: false` forces the server
+ * @returns {Promise<{ visited: Array<[number, number]>, path: Array<[number, number]>, frontier?: Array }>} 
  */
-export async function solve(grid, start, end, algorithm) {
-  const payload = { grid, start, end, algorithm };
+export async function solve(grid, start, end, algorithm, options = {}) {
+  const rows = grid.length;
+  const cols = rows > 0 ? grid[0].length : 0;
+  if (canSolveLocally(rows, cols, algorithm, options)) {
+    return solveLocal(packGrid(grid), rows, cols, start, end, algorithm, options);
+  }
+  return solveRemote(grid, start, end, algorithm, options);
+}
+
+// The server reads the grid from the payload, or from a map stored with createMap()
+function gridFields(grid, options) {
+  return options.mapId ? { map_id: options.mapId } : { grid };
+}
+
+/**
+ * Send the grid, start/end points, and chosen algorithm to the server. Takes
+ * the same arguments as solve(); with `options.mapId` the stored map is used and
+ * `grid` is not sent (may be null). A busy server may answer with a cheaper run
+ * (no exploration, near-shortest path), flagged by `degraded: true`, or reject
+ * the request with a "Server busy" error.
+ *
+ * With `options.timeline` (a Timeline from js/timeline.js) the request and
+ * response read are recorded as spans, the server records its own timeline,
+ * and the result carries `timeline: { id, fetch }` for fetchTimeline().
+ */
+export async function solveRemote(grid, start, end, algorithm, options = {}) {
+  const payload = { ...gridFields(grid, options), start, end, algorithm };
+  if (options.trace) payload.trace = options.trace;
+  if (options.sampleEvery) payload.sample_every = options.sampleEvery;
   const url = `${BASE_URL}/api/solve`;
+  const timeline = options.timeline || null;
+  const headers = { 'Content-Type': 'application/json' };
+  if (timeline) headers['X-Timeline'] = '1';
 
   try {
+    const sent = nowUs();
     const response = await fetch(url, {
       method: 'POST',
-      headers: { 'Content-Type': 'application/json' },
+      headers,
       body: JSON.stringify(payload),
     });
 
@@ -27,18 +85,118 @@ export async function solve(grid, start, end, algorithm) {
       throw new Error(`Server error: ${message}`);
     }
 
+    const received = nowUs();
     const data = await response.json();
     // Validate the expected fields
     if (!data.visited || !data.path) {
       throw new Error('Invalid response format from server.');
     }
 
-    return {
+    const result = {
       visited: data.visited,
       path: data.path,
+      frontier: data.frontier,
+      degraded: data.degraded === true,
     };
+    if (timeline) {
+      const fetchSpan = timeline.span('fetch /api/solve', sent, received);
+      timeline.span('read response', received);
+      result.timeline = { id: response.headers.get('X-Timeline-Id'), fetch: fetchSpan };
+    }
+    return result;
   } catch (err) {
-    console.error('Error in solve():', err);
+    console.error('Error in solveRemote():', err);
     throw err;
   }
 }
+
+/**
+ * Run a search on the server and return it as a binary trace file
+ * (see js/trace.js) for saving and offline replay.
+ *
+ * @param {number[][]} grid 2D array (0 = empty, 1 = wall)
+ * @param {[number, number]} start [row, col] of the start cell
+ * @param {[number, number]} end [row, col] of the end cell
+ * @param {string} algorithm Any algorithm key accepted by solve()
+ * @param {{ mapId?: string }} [options] Use a stored map instead of `grid`
+ * @returns {Promise<ArrayBuffer>}
+ */
+export async function recordTrace(grid, start, end, algorithm, options = {}) {
+  const response = await fetch(`${BASE_URL}/api/trace`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify({ ...gridFields(grid, options), start, end, algorithm }),
+  });
+  if (!response.ok) {
+    const errorData = await response.json().catch(() => ({}));
+    throw new Error(`Server error: ${errorData.error || response.statusText}`);
+  }
+  return response.arrayBuffer();
+}
+
+/**
+ * A server request timeline recorded with `X-Timeline: 1`, as trace-event JSON.
+ *
+ * @param {string} id The response's X-Timeline-Id
+ * @returns {Promise<{ traceEvents: object[] }>}
+ */
+export async function fetchTimeline(id) {
+  const response = await fetch(`${BASE_URL}/api/timelines/${id}`);
+  if (!response.ok) throw new Error(`Server error: timeline ${id} is not available`);
+  return response.json();
+}
+
+async function sendJson(method, path, body) {
+  const response = await fetch(`${BASE_URL}${path}`, {
+    method,
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify(body),
+  });
+  const data = await response.json().catch(() => ({}));
+  if (!response.ok) {
+    const err = new Error(`Server error: ${data.error || response.statusText}`);
+    err.status = response.status;
+    throw err;
+  }
+  return data;
+}
+
+/**
+ * Store a map on the server so later edits can be sent as deltas and solves can
+ * reference it by id.
+ *
+ * @param {number} rows
+ * @param {number} cols
+ * @param {number[]} runs Flat [start, length, value, ...] runs applied to an empty map
+ * @returns {Promise<{ map_id: string, version: number }>}
+ */
+export function createMap(rows, cols, runs) {
+  return sendJson('POST', '/api/maps', { rows, cols, runs });
+}
+
+/**
+ * Generate a seeded procedural map on the server; it is stored like an uploaded map.
+ *
+ * @param {string} generator 'random', 'division', 'prim', 'kruskal', 'caves', 'rooms' or 'city'
+ * @param {number} rows
+ * @param {number} cols
+ * @param {number} [seed]
+ * @param {Object} [params] Generator parameters, e.g. { density: 0.3 }
+ * @returns {Promise<{ map_id: string, version: number, rows: number, cols: number, runs: number[] }>}
+ */
+export function generateMap(generator, rows, cols, seed = 0, params = {}) {
+  return sendJson('POST', '/api/generate', { generator, rows, cols, seed, params });
+}
+
+/**
+ * Apply one edit stroke to a stored map.
+ *
+ * @param {string} mapId
+ * @param {number} baseVersion Version the delta was made against
+ * @param {number[]} runs Flat [start, length, value, ...] runs of changed cells
+ * @returns {Promise<{ version: number }>} Rejects with `err.status` 404 (unknown map)
+ *   or 409 (stale base version)
+ */
+export function patchMap(mapId, baseVersion, runs) {
+  return sendJson('PATCH', `/api/maps/${mapId}`, { base_version: baseVersion, runs });
+}
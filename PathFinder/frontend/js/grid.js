@@ -1,146 +1,244 @@
 // Manages the grid creation, user interactions for setting start/end/walls, and exposes state getters.
+// State lives in a GridModel (js/grid_model.js); a canvas GridView (js/grid_view.js) draws the
+// visible part of it. Wheel zooms, middle-drag or Shift+drag pans.
+// Edit tools: brush, rect, line, fill and stamp:<name> (js/stamps.js); whole maps can be generated on the server. Left button draws walls,
+// right button erases. Each stroke's changed cells are sent to the server copy (js/map_sync.js).
 
-let rows = 20;
-let cols = 20;
-let gridElements = []; // 2D array of cell divs
-let startPos = null;   // [r, c]
-let endPos = null;     // [r, c]
+import { GridModel, lineCells } from './grid_model.js';
+import { GridView } from './grid_view.js';
+import { adoptRemoteMap, attachMapSync, decodeRuns, sendStroke } from './map_sync.js';
+import { STAMPS } from './stamps.js';
+import { attachWorkerModel } from './worker_client.js';
+
+const ZOOM_PER_WHEEL_PIXEL = 0.0015;
+
+const gridCanvas = document.getElementById('grid');
+const view = new GridView(gridCanvas);
+
+let model = new GridModel(20, 20);
 let isMouseDown = false;
 let currentAction = null; // 'wall' or 'erase'
+let lastCell = null;      // [r, c] under the pointer at the previous drag event
+let panFrom = null;       // client [x, y] of the previous pan event
+let tool = 'brush';
+let shapeFrom = null;     // [r, c] where a rect/line drag started
 
-const gridContainer = document.getElementById('grid');
-
-document.body.addEventListener('mouseup', () => {
+function endDrag() {
+  if (shapeFrom && lastCell) {
+    const wall = currentAction === 'wall';
+    if (tool === 'rect') {
+      model.fillRect(shapeFrom[0], shapeFrom[1], lastCell[0], lastCell[1], wall);
+    } else {
+      model.drawLine(shapeFrom[0], shapeFrom[1], lastCell[0], lastCell[1], wall);
+    }
+    view.setPreview(null);
+  }
+  if (model.recording) sendStroke(model.endStroke());
   isMouseDown = false;
   currentAction = null;
-});
+  lastCell = null;
+  panFrom = null;
+  shapeFrom = null;
+}
 
-document.body.addEventListener('mouseleave', () => {
-  isMouseDown = false;
-  currentAction = null;
+document.body.addEventListener('mouseup', endDrag);
+document.body.addEventListener('mouseleave', endDrag);
+
+function isStart(r, c) {
+  return model.start !== null && model.start[0] === r && model.start[1] === c;
+}
+
+function isEnd(r, c) {
+  return model.end !== null && model.end[0] === r && model.end[1] === c;
+}
+
+function eventCell(e) {
+  const rect = gridCanvas.getBoundingClientRect();
+  return view.cellAt(e.clientX - rect.left, e.clientY - rect.top);
+}
+
+// Editing is locked while a search animates; panning and zooming are not
+function editable() {
+  return !gridCanvas.classList.contains('animating');
+}
+
+function paintCell(r, c) {
+  if (currentAction === 'wall') {
+    if (!isStart(r, c) && !isEnd(r, c)) model.setWall(r, c, true);
+  } else if (currentAction === 'erase') {
+    model.setWall(r, c, false);
+  }
+}
+
+// Disable context menu for right-click
+gridCanvas.addEventListener('contextmenu', (e) => e.preventDefault());
+
+gridCanvas.addEventListener('wheel', (e) => {
+  e.preventDefault();
+  view.zoomAt(e.offsetX, e.offsetY, Math.exp(-e.deltaY * ZOOM_PER_WHEEL_PIXEL));
+}, { passive: false });
+
+// Mouse down
+gridCanvas.addEventListener('mousedown', (e) => {
+  e.preventDefault();
+  if (e.button === 1 || (e.button === 0 && e.shiftKey)) {
+    panFrom = [e.clientX, e.clientY];
+    return;
+  }
+  const cell = eventCell(e);
+  if (!cell || !editable()) return;
+  const [r, c] = cell;
+  const isLeft = e.button === 0;
+  const isRight = e.button === 2;
+  const wall = model.isWall(r, c);
+
+  model.beginStroke();
+  if (isLeft && !model.start && !isEnd(r, c)) {
+    if (!wall) model.setStart([r, c]);
+  } else if (isLeft && !model.end && !isStart(r, c)) {
+    if (!wall) model.setEnd([r, c]);
+  } else if (isRight && isStart(r, c)) {
+    model.setStart(null);
+  } else if (isRight && isEnd(r, c)) {
+    model.setEnd(null);
+  } else if (isLeft || isRight) {
+    applyTool(r, c, isLeft, wall);
+  }
+  isMouseDown = true;
+  lastCell = cell;
 });
 
-function createCell(r, c) {
-  const cell = document.createElement('div');
-  cell.classList.add('cell', 'empty');
-  cell.dataset.row = r;
-  cell.dataset.col = c;
-  // Disable context menu for right-click
-  cell.addEventListener('contextmenu', (e) => e.preventDefault());
-
-  // Mouse down
-  cell.addEventListener('mousedown', (e) => {
-    e.preventDefault();
-    const isLeft = e.button === 0;
-    const isRight = e.button === 2;
-    const cls = cell.classList;
-    const rr = parseInt(cell.dataset.row, 10);
-    const cc = parseInt(cell.dataset.col, 10);
-
-    if (isLeft) {
-      if (!startPos && !cls.contains('end')) {
-        cls.replace('empty', 'start');
-        startPos = [rr, cc];
-      } else if (!endPos && !cls.contains('start')) {
-        cls.replace('empty', 'end');
-        endPos = [rr, cc];
-      } else if (!cls.contains('start') && !cls.contains('end')) {
-        // toggle wall
-        if (cls.contains('wall')) {
-          cls.replace('wall', 'empty');
-          currentAction = 'erase';
-        } else {
-          cls.replace('empty', 'wall');
-          currentAction = 'wall';
-        }
-      }
-    } else if (isRight) {
-      // Erase anything
-      if (cls.contains('start')) {
-        cls.replace('start', 'empty');
-        startPos = null;
-      } else if (cls.contains('end')) {
-        cls.replace('end', 'empty');
-        endPos = null;
-      } else if (cls.contains('wall')) {
-        cls.replace('wall', 'empty');
-      }
-      currentAction = 'erase';
+function applyTool(r, c, isLeft, wall) {
+  currentAction = isLeft ? 'wall' : 'erase';
+  if (tool === 'brush') {
+    if (!isLeft) {
+      model.setWall(r, c, false);
+    } else if (isStart(r, c) || isEnd(r, c)) {
+      currentAction = null;
+    } else {
+      // toggle wall
+      model.setWall(r, c, !wall);
+      currentAction = wall ? 'erase' : 'wall';
     }
-    isMouseDown = true;
-  });
-
-  // Mouse enter for drag
-  cell.addEventListener('mouseenter', () => {
-    if (!isMouseDown || !currentAction) return;
-    const cls = cell.classList;
-    if (currentAction === 'wall') {
-      if (!cls.contains('start') && !cls.contains('end') && !cls.contains('wall')) {
-        cls.replace('empty', 'wall');
-      }
-    } else if (currentAction === 'erase') {
-      if (cls.contains('wall')) {
-        cls.replace('wall', 'empty');
-      }
-    }
-  });
+  } else if (tool === 'rect' || tool === 'line') {
+    shapeFrom = [r, c];
+    view.setPreview({ kind: tool, from: shapeFrom, to: shapeFrom, wall: isLeft });
+  } else if (tool === 'fill') {
+    model.floodFill(r, c, isLeft);
+    currentAction = null;
+  } else if (tool.startsWith('stamp:')) {
+    model.stamp(STAMPS[tool.slice('stamp:'.length)], r, c, isLeft);
+    currentAction = null;
+  }
+}
 
-  return cell;
+// Drag: pan, or paint every cell between this event and the previous one
+window.addEventListener('mousemove', (e) => {
+  if (panFrom) {
+    view.pan(e.clientX - panFrom[0], e.clientY - panFrom[1]);
+    panFrom = [e.clientX, e.clientY];
+    return;
+  }
+  if (!isMouseDown || !currentAction || !editable()) return;
+  const cell = eventCell(e);
+  if (!cell) return;
+  if (shapeFrom) {
+    lastCell = cell;
+    view.setPreview({ kind: tool, from: shapeFrom, to: cell, wall: currentAction === 'wall' });
+    return;
+  }
+  const from = lastCell || cell;
+  for (const [r, c] of lineCells(from[0], from[1], cell[0], cell[1])) paintCell(r, c);
+  lastCell = cell;
+});
+
+function useModel(next) {
+  model = next;
+  view.setModel(model);
+  attachWorkerModel(model);
+  attachMapSync(model);
+}
+
+/**
+ * Choose the edit tool: 'brush', 'rect', 'line', 'fill' or 'stamp:<name>' (see js/stamps.js).
+ * @param {string} name
+ */
+export function setTool(name) {
+  tool = name;
 }
 
 /**
  * Initialize the grid in the container.
  * @param {number} r Number of rows (default 20)
  * @param {number} c Number of columns (default 20)
+ * @param {Uint8Array|number[]} [walls] Row-major wall flags (1 = wall)
  */
-export function initializeGrid(r = 20, c = 20) {
-  rows = r;
-  cols = c;
-  gridContainer.innerHTML = '';
-  gridContainer.classList.remove('animating');
-  gridElements = [];
-  startPos = null;
-  endPos = null;
-
-  // Set CSS grid properties
-  gridContainer.style.gridTemplateColumns = `repeat(${cols}, 1rem)`;
-  gridContainer.style.gridTemplateRows = `repeat(${rows}, 1rem)`;
-
-  for (let i = 0; i < rows; i++) {
-    const rowArr = [];
-    for (let j = 0; j < cols; j++) {
-      const cell = createCell(i, j);
-      gridContainer.appendChild(cell);
-      rowArr.push(cell);
-    }
-    gridElements.push(rowArr);
-  }
+export function initializeGrid(r = 20, c = 20, walls = undefined) {
+  gridCanvas.classList.remove('animating');
+  useModel(new GridModel(r, c, walls));
+}
+
+/**
+ * Rebuild the grid from a saved state (e.g. a decoded trace file).
+ * @param {number} r Number of rows
+ * @param {number} c Number of columns
+ * @param {Uint8Array|number[]} walls Row-major wall flags (1 = wall)
+ * @param {[number, number]} start [row, col] of the start cell
+ * @param {[number, number]} end [row, col] of the end cell
+ */
+export function loadGridState(r, c, walls, start, end) {
+  initializeGrid(r, c, walls);
+  model.setStart(start);
+  model.setEnd(end);
+}
+
+/**
+ * Load a map generated on the server (see generateMap in js/api.js); later
+ * edits and solves use the server's stored copy directly.
+ * @param {{ map_id: string, version: number, rows: number, cols: number, runs: number[] }} map
+ */
+export function loadGeneratedMap(map) {
+  initializeGrid(map.rows, map.cols, decodeRuns(map.runs, map.rows * map.cols));
+  adoptRemoteMap(map.map_id, map.version);
+}
+
+/** Zoom and center the view so the whole grid is visible. */
+export function fitGrid() {
+  view.fit();
+}
+
+/**
+ * The grid model backing the view; mutate it to change what is drawn.
+ * @returns {GridModel}
+ */
+export function getModel() {
+  return model;
 }
 
 /**
  * Returns the current grid state as numbers, plus start/end positions.
  */
 export function getGridState() {
-  const grid = gridElements.map((row) =>
-    row.map((cell) => (cell.classList.contains('wall') ? 1 : 0))
-  );
   return {
-    grid,
-    start: startPos,
-    end: endPos,
+    grid: model.toRows(),
+    start: model.start,
+    end: model.end,
   };
 }
 
+/**
+ * Returns the grid size and start/end positions, without copying the grid.
+ */
+export function getEndpoints() {
+  return { rows: model.rows, cols: model.cols, start: model.start, end: model.end };
+}
+
 /**
  * Clears only animation classes (visited & path), preserving walls/start/end.
  */
 export function clearAnimations() {
-  gridContainer.classList.remove('animating');
-  gridElements.forEach((row) => {
-    row.forEach((cell) => {
-      cell.classList.remove('visited', 'path');
-    });
-  });
+  gridCanvas.classList.remove('animating');
+  model.clearOverlay();
 }
 
 /**
@@ -148,14 +246,8 @@ export function clearAnimations() {
  * If preservePoints=false, also clears start and end.
  */
 export function clearGrid(preservePoints = false) {
-  gridContainer.classList.remove('animating');
-  gridElements.forEach((row) => {
-    row.forEach((cell) => {
-      cell.className = 'cell empty';
-    });
-  });
-  if (!preservePoints) {
-    startPos = null;
-    endPos = null;
-  }
+  gridCanvas.classList.remove('animating');
+  model.clear(!preservePoints);
+  // Cheaper to upload the empty grid afresh than to send a delta covering every cell
+  attachMapSync(model);
 }
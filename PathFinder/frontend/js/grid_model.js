@@ -0,0 +1,362 @@
+// Typed-array model of the grid: the single source of truth for walls,
+// start/end and the search overlay. Views read it and redraw only the regions
+// marked dirty since their last look, so edits cost O(changed cells).
+
+export const EMPTY = 0;
+export const WALL = 1;
+
+export const NO_OVERLAY = 0;
+export const VISITED = 1;
+export const PATH = 2;
+export const FRONTIER = 3;
+
+// Dirty-region consumers: the renderer (anything visible changed) and the
+// solver worker sync (walls changed)
+const RENDER = 0;
+const SYNC = 1;
+
+// Shared when the page is cross-origin isolated, so the solver worker can read
+// the cells in place instead of receiving copies
+function allocateCells(size) {
+  const shared = typeof SharedArrayBuffer !== 'undefined' && globalThis.crossOriginIsolated;
+  return new Uint8Array(shared ? new SharedArrayBuffer(size) : new ArrayBuffer(size));
+}
+
+/**
+ * Cells on the straight line from (r0, c0) to (r1, c1), both ends included
+ * (Bresenham), so fast strokes leave no gaps.
+ * @returns {Array<[number, number]>}
+ */
+export function lineCells(r0, c0, r1, c1) {
+  const cells = [];
+  const dr = Math.abs(r1 - r0);
+  const dc = Math.abs(c1 - c0);
+  const sr = r0 < r1 ? 1 : -1;
+  const sc = c0 < c1 ? 1 : -1;
+  let err = dc - dr;
+  let r = r0;
+  let c = c0;
+  for (;;) {
+    cells.push([r, c]);
+    if (r === r1 && c === c1) return cells;
+    const e2 = 2 * err;
+    if (e2 > -dr) {
+      err -= dr;
+      c += sc;
+    }
+    if (e2 < dc) {
+      err += dc;
+      r += sr;
+    }
+  }
+}
+
+export class GridModel {
+  /**
+   * @param {number} rows
+   * @param {number} cols
+   * @param {Uint8Array|number[]} [walls] Row-major wall flags (1 = wall)
+   */
+  constructor(rows, cols, walls) {
+    this.rows = rows;
+    this.cols = cols;
+    this.cells = allocateCells(rows * cols);
+    this.overlay = new Uint8Array(rows * cols);
+    this.start = null; // [r, c]
+    this.end = null;   // [r, c]
+    if (walls) this.cells.set(walls);
+    // Inclusive [r0, c0, r1, c1] per consumer, or null when clean
+    this.dirty = [null, null];
+    // Called when a clean model first gets a region to redraw
+    this.onDirty = null;
+    // Bounding rectangle of overlay writes since the last clearOverlay()
+    this.overlayBounds = null;
+    // While an edit stroke records (see beginStroke()): 1 per cell whose wall
+    // changed, and the inclusive [r0, c0, r1, c1] bounds of those cells
+    this.recording = false;
+    this.strokeChanged = null;
+    this.strokeBounds = null;
+    // Scratch marks for floodFill(), kept zeroed between calls
+    this.fillSeen = null;
+    this.markDirty(0, 0, rows - 1, cols - 1, true);
+  }
+
+  inBounds(r, c) {
+    return r >= 0 && r < this.rows && c >= 0 && c < this.cols;
+  }
+
+  isWall(r, c) {
+    return this.cells[r * this.cols + c] === WALL;
+  }
+
+  isEndpoint(r, c) {
+    return (this.start !== null && this.start[0] === r && this.start[1] === c)
+      || (this.end !== null && this.end[0] === r && this.end[1] === c);
+  }
+
+  /**
+   * Grow the dirty regions to cover rows r0..r1 and columns c0..c1 (inclusive).
+   * @param {boolean} walls Whether wall data changed (needs syncing to the worker)
+   */
+  markDirty(r0, c0, r1, c1, walls = false) {
+    const wasClean = this.dirty[RENDER] === null;
+    for (const consumer of walls ? [RENDER, SYNC] : [RENDER]) {
+      const d = this.dirty[consumer];
+      this.dirty[consumer] = d === null ? [r0, c0, r1, c1] : [
+        Math.min(d[0], r0), Math.min(d[1], c0), Math.max(d[2], r1), Math.max(d[3], c1),
+      ];
+    }
+    if (wasClean && this.onDirty) this.onDirty();
+  }
+
+  /** Return and clear the region to redraw, or null if nothing changed. */
+  takeRenderDirty() {
+    const d = this.dirty[RENDER];
+    this.dirty[RENDER] = null;
+    return d;
+  }
+
+  /** Return and clear the region of wall changes not yet synced, or null. */
+  takeSyncDirty() {
+    const d = this.dirty[SYNC];
+    this.dirty[SYNC] = null;
+    return d;
+  }
+
+  /** @returns {boolean} Whether the cell changed */
+  setWall(r, c, wall) {
+    const changed = this.setSpan(r, c, c, wall ? WALL : EMPTY);
+    if (changed) this.noteWallChange(r, c, r, c);
+    return changed;
+  }
+
+  // Set cells c0..c1 of row r to `value` without marking anything dirty;
+  // returns whether any cell changed
+  setSpan(r, c0, c1, value) {
+    const { cells, strokeChanged } = this;
+    const base = r * this.cols;
+    let changed = false;
+    for (let i = base + c0; i <= base + c1; i++) {
+      if (cells[i] === value) continue;
+      cells[i] = value;
+      if (this.recording) strokeChanged[i] = 1;
+      changed = true;
+    }
+    return changed;
+  }
+
+  // Walls changed somewhere in rows r0..r1, columns c0..c1
+  noteWallChange(r0, c0, r1, c1) {
+    this.markDirty(r0, c0, r1, c1, true);
+    if (!this.recording) return;
+    const b = this.strokeBounds;
+    this.strokeBounds = b === null ? [r0, c0, r1, c1] : [
+      Math.min(b[0], r0), Math.min(b[1], c0), Math.max(b[2], r1), Math.max(b[3], c1),
+    ];
+  }
+
+  // Walls never cover start/end; bulk tools paint around those cells
+  paintSpan(r, c0, c1, wall) {
+    if (!wall) return this.setSpan(r, c0, c1, EMPTY);
+    const skipped = [this.start, this.end]
+      .filter((p) => p && p[0] === r && p[1] >= c0 && p[1] <= c1)
+      .map((p) => p[1])
+      .sort((a, b) => a - b);
+    let changed = false;
+    let from = c0;
+    for (const c of [...skipped, c1 + 1]) {
+      if (c > from) changed = this.setSpan(r, from, c - 1, WALL) || changed;
+      from = Math.max(from, c + 1);
+    }
+    return changed;
+  }
+
+  paint(r, c, wall) {
+    if (this.paintSpan(r, c, c, wall)) this.noteWallChange(r, c, r, c);
+  }
+
+  /** Start recording which cells the next edits change (see endStroke()). */
+  beginStroke() {
+    if (this.strokeChanged === null) this.strokeChanged = new Uint8Array(this.cells.length);
+    this.recording = true;
+    this.strokeBounds = null;
+  }
+
+  /**
+   * Stop recording and return the changed cells' current values as runs:
+   * consecutive changed cells with the same value collapse into one
+   * [start, length, value] triple, the delta format of PATCH /api/maps/<id>.
+   * @returns {number[]} Flat [start, length, value, ...]
+   */
+  endStroke() {
+    const runs = [];
+    const b = this.strokeBounds;
+    this.recording = false;
+    this.strokeBounds = null;
+    if (b === null) return runs;
+    const { cells, cols, strokeChanged } = this;
+    for (let r = b[0]; r <= b[2]; r++) {
+      for (let i = r * cols + b[1]; i <= r * cols + b[3]; i++) {
+        if (!strokeChanged[i]) continue;
+        strokeChanged[i] = 0;
+        const last = runs.length - 3;
+        if (last >= 0 && runs[last] + runs[last + 1] === i && runs[last + 2] === cells[i]) {
+          runs[last + 1] += 1;
+        } else {
+          runs.push(i, 1, cells[i]);
+        }
+      }
+    }
+    return runs;
+  }
+
+  /** Set every cell of the rectangle spanned by two corners (inclusive). */
+  fillRect(r0, c0, r1, c1, wall) {
+    const top = Math.max(0, Math.min(r0, r1));
+    const bottom = Math.min(this.rows - 1, Math.max(r0, r1));
+    const left = Math.max(0, Math.min(c0, c1));
+    const right = Math.min(this.cols - 1, Math.max(c0, c1));
+    let changed = false;
+    for (let r = top; r <= bottom; r++) changed = this.paintSpan(r, left, right, wall) || changed;
+    if (changed) this.noteWallChange(top, left, bottom, right);
+  }
+
+  /** Set every cell on the straight line between two cells. */
+  drawLine(r0, c0, r1, c1, wall) {
+    for (const [r, c] of lineCells(r0, c0, r1, c1)) {
+      if (this.inBounds(r, c)) this.paint(r, c, wall);
+    }
+  }
+
+  /**
+   * Paint-bucket: set the 4-connected region of cells sharing (r, c)'s state.
+   * Nothing happens when the region is already in the requested state.
+   * Scanline fill: each row span is claimed and painted at once, and the rows
+   * above and below are seeded once per run of matching cells.
+   */
+  floodFill(r, c, wall) {
+    const target = wall ? WALL : EMPTY;
+    const { cells, cols } = this;
+    if (cells[r * cols + c] === target) return;
+    const from = cells[r * cols + c];
+    // Painted cells stop matching `from`; `seen` only matters for endpoints, which keep it
+    if (this.fillSeen === null) this.fillSeen = new Uint8Array(cells.length);
+    const seen = this.fillSeen;
+    const open = (i) => cells[i] === from && !seen[i];
+    let bounds = [r, c, r, c];
+    const stack = [r * cols + c];
+    while (stack.length > 0) {
+      const i = stack.pop();
+      if (!open(i)) continue;
+      const row = Math.floor(i / cols);
+      const base = row * cols;
+      let lo = i;
+      let hi = i;
+      while (lo > base && open(lo - 1)) lo--;
+      while (hi < base + cols - 1 && open(hi + 1)) hi++;
+      seen.fill(1, lo, hi + 1);
+      this.paintSpan(row, lo - base, hi - base, wall);
+      bounds = [Math.min(bounds[0], row), Math.min(bounds[1], lo - base),
+        Math.max(bounds[2], row), Math.max(bounds[3], hi - base)];
+      for (const next of [row - 1, row + 1]) {
+        if (next < 0 || next >= this.rows) continue;
+        const offset = (next - row) * cols;
+        for (let k = lo; k <= hi; k++) {
+          if (open(k + offset) && (k === lo || !open(k + offset - 1))) stack.push(k + offset);
+        }
+      }
+    }
+    seen.fill(0, bounds[0] * cols, (bounds[2] + 1) * cols);
+    this.noteWallChange(bounds[0], bounds[1], bounds[2], bounds[3]);
+  }
+
+  /**
+   * Stamp a pattern centered on (r, c): '#' sets the cell, anything else leaves it.
+   * @param {string[]} pattern Rows of the stamp
+   */
+  stamp(pattern, r, c, wall) {
+    const top = r - Math.floor(pattern.length / 2);
+    const left = c - Math.floor(pattern[0].length / 2);
+    pattern.forEach((line, dr) => {
+      for (let dc = 0; dc < line.length; dc++) {
+        if (line[dc] === '#' && this.inBounds(top + dr, left + dc)) {
+          this.paint(top + dr, left + dc, wall);
+        }
+      }
+    });
+  }
+
+  setStart(pos) {
+    this.start = this.moveEndpoint(this.start, pos);
+  }
+
+  setEnd(pos) {
+    this.end = this.moveEndpoint(this.end, pos);
+  }
+
+  moveEndpoint(previous, pos) {
+    if (previous) this.markDirty(previous[0], previous[1], previous[0], previous[1]);
+    if (pos) this.markDirty(pos[0], pos[1], pos[0], pos[1]);
+    return pos ? [pos[0], pos[1]] : null;
+  }
+
+  setOverlay(r, c, value) {
+    const i = r * this.cols + c;
+    if (this.overlay[i] === value) return;
+    this.overlay[i] = value;
+    this.markDirty(r, c, r, c);
+    const b = this.overlayBounds;
+    this.overlayBounds = b === null ? [r, c, r, c] : [
+      Math.min(b[0], r), Math.min(b[1], c), Math.max(b[2], r), Math.max(b[3], c),
+    ];
+  }
+
+  /** Mark every non-wall, non-endpoint cell in a rectangle visited. */
+  markVisited(r, c, h = 1, w = 1) {
+    const r1 = Math.min(r + h, this.rows);
+    const c1 = Math.min(c + w, this.cols);
+    for (let rr = Math.max(r, 0); rr < r1; rr++) {
+      for (let cc = Math.max(c, 0); cc < c1; cc++) {
+        if (!this.isWall(rr, cc) && !this.isEndpoint(rr, cc)) this.setOverlay(rr, cc, VISITED);
+      }
+    }
+  }
+
+  /** Mark a cell as on the open list (frontier traces). */
+  markFrontier(r, c) {
+    if (this.inBounds(r, c) && !this.isWall(r, c) && !this.isEndpoint(r, c)) this.setOverlay(r, c, FRONTIER);
+  }
+
+  markPath(r, c) {
+    if (this.inBounds(r, c) && !this.isEndpoint(r, c)) this.setOverlay(r, c, PATH);
+  }
+
+  clearOverlay() {
+    const b = this.overlayBounds;
+    if (b === null) return;
+    this.overlay.fill(NO_OVERLAY);
+    this.overlayBounds = null;
+    this.markDirty(b[0], b[1], b[2], b[3]);
+  }
+
+  /** Remove walls and the overlay; keeps start/end unless `clearPoints`. */
+  clear(clearPoints = true) {
+    this.cells.fill(EMPTY);
+    this.overlay.fill(NO_OVERLAY);
+    this.overlayBounds = null;
+    if (clearPoints) {
+      this.start = null;
+      this.end = null;
+    }
+    this.markDirty(0, 0, this.rows - 1, this.cols - 1, true);
+  }
+
+  /** Nested-array copy of the walls (the server's JSON grid format). */
+  toRows() {
+    const grid = new Array(this.rows);
+    for (let r = 0; r < this.rows; r++) {
+      grid[r] = Array.from(this.cells.subarray(r * this.cols, (r + 1) * this.cols));
+    }
+    return grid;
+  }
+}
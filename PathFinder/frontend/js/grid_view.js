@@ -0,0 +1,290 @@
+// Canvas view of a GridModel with pan and zoom. Only the visible part of the
+// grid is drawn, one frame at a time, so the cost of a redraw depends on the
+// canvas size rather than the map size.
+//
+// Zoomed out past one cell per pixel, cells are drawn from a level-of-detail
+// pyramid: level k holds one code per 2^k x 2^k block, the most important
+// state in the block (path > wall > frontier > visited > empty), so thin walls
+// and paths stay visible on huge maps. The pyramid is updated only inside the
+// model's dirty regions.
+
+import { FRONTIER, PATH, VISITED, WALL } from './grid_model.js';
+
+const EMPTY_CODE = 0;
+const VISITED_CODE = 1;
+const FRONTIER_CODE = 2;
+const WALL_CODE = 3;
+const PATH_CODE = 4;
+
+const MIN_SCALE = 1 / 64;  // pixels per cell
+const MAX_SCALE = 64;
+const GRID_LINE_SCALE = 8; // draw cell borders at and above this zoom
+const MIN_MARKER_SIZE = 5; // start/end stay visible when zoomed out
+
+function cssColor(name, fallback) {
+  const value = getComputedStyle(document.documentElement).getPropertyValue(name).trim();
+  return value || fallback;
+}
+
+// A CSS color as one ImageData pixel, read as a native-endian u32
+function pixel(color) {
+  const ctx = document.createElement('canvas').getContext('2d');
+  ctx.fillStyle = color;
+  ctx.fillRect(0, 0, 1, 1);
+  return new Uint32Array(ctx.getImageData(0, 0, 1, 1).data.buffer)[0];
+}
+
+export class GridView {
+  /**
+   * @param {HTMLCanvasElement} canvas
+   */
+  constructor(canvas) {
+    this.canvas = canvas;
+    this.ctx = canvas.getContext('2d');
+    this.scratch = document.createElement('canvas');
+    this.model = null;
+    this.levels = [];   // levels[k - 1] is the 2^k pyramid level
+    this.scale = 16;    // pixels per cell
+    this.originR = 0;   // grid coordinates of the canvas's top-left corner
+    this.originC = 0;
+    this.frameQueued = false;
+    this.preview = null; // rect/line being dragged, see setPreview()
+
+    this.colors = {
+      empty: cssColor('--color-cell-empty', '#ffffff'),
+      wall: cssColor('--color-cell-wall', '#2f3542'),
+      start: cssColor('--color-cell-start', '#ffa502'),
+      end: cssColor('--color-cell-end', '#ff4757'),
+      visited: cssColor('--color-cell-visited', '#70a1ff'),
+      frontier: cssColor('--color-cell-frontier', '#eccc68'),
+      path: cssColor('--color-cell-path', '#2ed573'),
+      border: cssColor('--color-cell-border', '#d1d8e0'),
+    };
+    this.palette = Uint32Array.from(
+      [this.colors.empty, this.colors.visited, this.colors.frontier, this.colors.wall, this.colors.path].map(pixel));
+
+    new ResizeObserver(() => this.resize()).observe(canvas.parentElement);
+    this.resize();
+  }
+
+  /** Show a new model, zoomed to fit. */
+  setModel(model) {
+    this.model = model;
+    this.levels = [];
+    let rows = model.rows;
+    let cols = model.cols;
+    while (rows > 1 || cols > 1) {
+      rows = Math.ceil(rows / 2);
+      cols = Math.ceil(cols / 2);
+      this.levels.push({ rows, cols, codes: new Uint8Array(rows * cols) });
+    }
+    model.onDirty = () => this.requestFrame();
+    this.fit();
+  }
+
+  /**
+   * Outline a pending rect/line edit, or clear it with null.
+   * @param {{ kind: 'rect'|'line', from: [number, number], to: [number, number], wall: boolean }|null} shape
+   */
+  setPreview(shape) {
+    this.preview = shape;
+    this.requestFrame();
+  }
+
+  resize() {
+    const parent = this.canvas.parentElement;
+    this.canvas.width = parent.clientWidth;
+    this.canvas.height = parent.clientHeight;
+    this.requestFrame();
+  }
+
+  /** Zoom and center so the whole grid is visible. */
+  fit() {
+    const { rows, cols } = this.model;
+    const scale = Math.min(this.canvas.width / cols, this.canvas.height / rows);
+    this.scale = Math.max(MIN_SCALE, Math.min(MAX_SCALE, scale));
+    this.originC = (cols - this.canvas.width / this.scale) / 2;
+    this.originR = (rows - this.canvas.height / this.scale) / 2;
+    this.requestFrame();
+  }
+
+  /** Move the view by a number of canvas pixels. */
+  pan(dx, dy) {
+    this.originC -= dx / this.scale;
+    this.originR -= dy / this.scale;
+    this.requestFrame();
+  }
+
+  /** Zoom by `factor`, keeping the grid point under canvas pixel (x, y) in place. */
+  zoomAt(x, y, factor) {
+    const scale = Math.max(MIN_SCALE, Math.min(MAX_SCALE, this.scale * factor));
+    const gc = this.originC + x / this.scale;
+    const gr = this.originR + y / this.scale;
+    this.scale = scale;
+    this.originC = gc - x / scale;
+    this.originR = gr - y / scale;
+    this.requestFrame();
+  }
+
+  /**
+   * The cell under canvas pixel (x, y), or null outside the grid.
+   * @returns {[number, number]|null}
+   */
+  cellAt(x, y) {
+    const r = Math.floor(this.originR + y / this.scale);
+    const c = Math.floor(this.originC + x / this.scale);
+    return this.model.inBounds(r, c) ? [r, c] : null;
+  }
+
+  requestFrame() {
+    if (this.frameQueued) return;
+    this.frameQueued = true;
+    requestAnimationFrame(() => {
+      this.frameQueued = false;
+      this.draw();
+    });
+  }
+
+  // Display code of a base cell
+  code(i) {
+    const { cells, overlay } = this.model;
+    if (overlay[i] === PATH) return PATH_CODE;
+    if (cells[i] === WALL) return WALL_CODE;
+    if (overlay[i] === FRONTIER) return FRONTIER_CODE;
+    if (overlay[i] === VISITED) return VISITED_CODE;
+    return EMPTY_CODE;
+  }
+
+  // Recompute the pyramid above the base-cell rectangle r0..r1 x c0..c1
+  updateLevels([r0, c0, r1, c1]) {
+    let below = null; // { rows, cols, codes } or null for the base grid
+    const base = this.model;
+    for (const level of this.levels) {
+      r0 >>= 1; c0 >>= 1; r1 >>= 1; c1 >>= 1;
+      const belowRows = below ? below.rows : base.rows;
+      const belowCols = below ? below.cols : base.cols;
+      for (let r = r0; r <= r1; r++) {
+        for (let c = c0; c <= c1; c++) {
+          let best = EMPTY_CODE;
+          for (let dr = 0; dr < 2; dr++) {
+            const rr = 2 * r + dr;
+            if (rr >= belowRows) break;
+            for (let dc = 0; dc < 2; dc++) {
+              const cc = 2 * c + dc;
+              if (cc >= belowCols) break;
+              const i = rr * belowCols + cc;
+              const code = below ? below.codes[i] : this.code(i);
+              if (code > best) best = code;
+            }
+          }
+          level.codes[r * level.cols + c] = best;
+        }
+      }
+      below = level;
+    }
+  }
+
+  draw() {
+    if (!this.model) return;
+    const dirty = this.model.takeRenderDirty();
+    if (dirty) this.updateLevels(dirty);
+
+    const { ctx, canvas, scale, model } = this;
+    ctx.clearRect(0, 0, canvas.width, canvas.height);
+
+    // Pick the finest level with at most about one entry per pixel
+    const k = scale >= 1 ? 0 : Math.min(this.levels.length, Math.floor(Math.log2(1 / scale)));
+    const size = 2 ** k; // base cells per level entry
+    const levelRows = k === 0 ? model.rows : this.levels[k - 1].rows;
+    const levelCols = k === 0 ? model.cols : this.levels[k - 1].cols;
+    const codeAt = k === 0
+      ? (i) => this.code(i)
+      : (i) => this.levels[k - 1].codes[i];
+
+    const r0 = Math.max(0, Math.floor(this.originR / size));
+    const c0 = Math.max(0, Math.floor(this.originC / size));
+    const r1 = Math.min(levelRows, Math.ceil((this.originR + canvas.height / scale) / size));
+    const c1 = Math.min(levelCols, Math.ceil((this.originC + canvas.width / scale) / size));
+    if (r1 > r0 && c1 > c0) {
+      // One pixel per visible entry, then scaled up onto the canvas unsmoothed
+      const w = c1 - c0;
+      const h = r1 - r0;
+      const image = new ImageData(w, h);
+      const pixels = new Uint32Array(image.data.buffer);
+      const { palette } = this;
+      for (let r = 0; r < h; r++) {
+        const row = (r0 + r) * levelCols + c0;
+        for (let c = 0; c < w; c++) {
+          pixels[r * w + c] = palette[codeAt(row + c)];
+        }
+      }
+      this.scratch.width = w;
+      this.scratch.height = h;
+      this.scratch.getContext('2d').putImageData(image, 0, 0);
+      ctx.imageSmoothingEnabled = false;
+      ctx.drawImage(this.scratch,
+        (c0 * size - this.originC) * scale, (r0 * size - this.originR) * scale,
+        w * size * scale, h * size * scale);
+    }
+
+    if (scale >= GRID_LINE_SCALE) this.drawGridLines();
+    this.drawMarker(model.start, this.colors.start);
+    this.drawMarker(model.end, this.colors.end);
+    if (this.preview) this.drawPreview(this.preview);
+  }
+
+  drawPreview({ kind, from, to, wall }) {
+    const { ctx, scale } = this;
+    const x = (c) => (c - this.originC) * scale;
+    const y = (r) => (r - this.originR) * scale;
+    ctx.save();
+    ctx.globalAlpha = 0.7;
+    ctx.strokeStyle = wall ? this.colors.wall : this.colors.end;
+    ctx.lineWidth = Math.max(2, Math.min(scale, 6));
+    if (kind === 'rect') {
+      const r0 = Math.min(from[0], to[0]);
+      const c0 = Math.min(from[1], to[1]);
+      const r1 = Math.max(from[0], to[0]) + 1;
+      const c1 = Math.max(from[1], to[1]) + 1;
+      ctx.strokeRect(x(c0), y(r0), x(c1) - x(c0), y(r1) - y(r0));
+    } else {
+      ctx.beginPath();
+      ctx.moveTo(x(from[1] + 0.5), y(from[0] + 0.5));
+      ctx.lineTo(x(to[1] + 0.5), y(to[0] + 0.5));
+      ctx.stroke();
+    }
+    ctx.restore();
+  }
+
+  drawGridLines() {
+    const { ctx, canvas, scale, model } = this;
+    const r0 = Math.max(0, Math.floor(this.originR));
+    const c0 = Math.max(0, Math.floor(this.originC));
+    const r1 = Math.min(model.rows, Math.ceil(this.originR + canvas.height / scale));
+    const c1 = Math.min(model.cols, Math.ceil(this.originC + canvas.width / scale));
+    const x = (c) => Math.round((c - this.originC) * scale) + 0.5;
+    const y = (r) => Math.round((r - this.originR) * scale) + 0.5;
+
+    ctx.strokeStyle = this.colors.border;
+    ctx.lineWidth = 1;
+    ctx.beginPath();
+    for (let r = r0; r <= r1; r++) {
+      ctx.moveTo(x(c0), y(r));
+      ctx.lineTo(x(c1), y(r));
+    }
+    for (let c = c0; c <= c1; c++) {
+      ctx.moveTo(x(c), y(r0));
+      ctx.lineTo(x(c), y(r1));
+    }
+    ctx.stroke();
+  }
+
+  drawMarker(pos, color) {
+    if (!pos) return;
+    const size = Math.max(this.scale, MIN_MARKER_SIZE);
+    const cx = (pos[1] + 0.5 - this.originC) * this.scale;
+    const cy = (pos[0] + 0.5 - this.originR) * this.scale;
+    this.ctx.fillStyle = color;
+    this.ctx.fillRect(cx - size / 2, cy - size / 2, size, size);
+  }
+}
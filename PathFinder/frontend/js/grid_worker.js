@@ -0,0 +1,140 @@
+// Module worker that owns the solver's copy of the grid and does all the heavy
+// lifting off the main thread: building request payloads, solving in the
+// browser or fetching from the server, and decoding responses and trace files.
+// Only paint commands (typed arrays of cell indices) are posted back.
+//
+// Messages in:
+//   { type: 'reset', rows, cols, walls? }       replace the grid (walls: Uint8Array, transferred,
+//                                              or shared with the page's GridModel)
+//   { type: 'patch', r0, c0, width, data }     overwrite a rectangle of cells (row-major data)
+//   { type: 'solve', id, start, end, algorithm, options }   options.mapId: server copy to use;
+//                                              options.timeline: true to record spans
+//   { type: 'record', id, start, end, algorithm, options }
+//   { type: 'decode', id, buffer }             parse a trace file
+// Messages out:
+//   { type: 'paint', id, visited, path, frontier?, timeline? }   visited/path as Int32Array cell
+//                                              indices, or [row, col, height, width] block lists;
+//                                              frontier: { at, offsets, cells } (see flattenFrontier)
+//                                              timeline: { events, id?, fetch? } (see js/timeline.js)
+//   { type: 'trace', id, buffer }              recorded trace file bytes
+//   { type: 'decoded', id, trace }             result of decodeTrace()
+//   { type: 'error', id, message }
+
+import { canSolveLocally, recordTrace, solveRemote } from './api.js';
+import { solveLocal } from './local_engine.js';
+import { Timeline, WORKER_PID } from './timeline.js';
+import { decodeTrace } from './trace.js';
+
+let rows = 0;
+let cols = 0;
+let cells = new Uint8Array(0);
+
+// The server takes the grid as nested arrays
+function gridRows() {
+  const grid = new Array(rows);
+  for (let r = 0; r < rows; r++) {
+    grid[r] = Array.from(cells.subarray(r * cols, (r + 1) * cols));
+  }
+  return grid;
+}
+
+// Server entries are [row, col] pairs, except block-based searches which
+// report [row, col, height, width] blocks; only the former flatten to indices
+function toIndices(entries) {
+  if (entries.length > 0 && entries[0].length !== 2) return entries;
+  const out = new Int32Array(entries.length);
+  for (let i = 0; i < entries.length; i++) {
+    out[i] = entries[i][0] * cols + entries[i][1];
+  }
+  return out;
+}
+
+// Frontier snapshots ([[expansion, entries], ...], entries being cells or
+// blocks) as Int32Arrays: snapshot s was taken at expansion at[s] and holds
+// the cell indices cells[offsets[s]] up to cells[offsets[s + 1]]
+function flattenFrontier(snapshots) {
+  const at = new Int32Array(snapshots.length);
+  const offsets = new Int32Array(snapshots.length + 1);
+  const out = [];
+  snapshots.forEach(([expansion, entries], s) => {
+    at[s] = expansion;
+    for (const [r, c, h = 1, w = 1] of entries) {
+      for (let rr = r; rr < Math.min(r + h, rows); rr++) {
+        for (let cc = c; cc < Math.min(c + w, cols); cc++) out.push(rr * cols + cc);
+      }
+    }
+    offsets[s + 1] = out.length;
+  });
+  return { at, offsets, cells: Int32Array.from(out) };
+}
+
+function transferables(...values) {
+  return values.filter(ArrayBuffer.isView).map((view) => view.buffer);
+}
+
+async function solve({ id, start, end, algorithm, options = {} }) {
+  const timeline = options.timeline ? new Timeline(WORKER_PID) : null;
+  // Without a timeline, measure() is just a call
+  const measure = timeline ? (name, fn) => timeline.measure(name, fn) : (name, fn) => fn();
+  let visited;
+  let path;
+  let frontier = null;
+  let server = null;
+  if (canSolveLocally(rows, cols, algorithm, options)) {
+    ({ visited, path } = await measure('solve locally', () => solveLocal(cells, rows, cols, start, end,
+      algorithm, { ...options, timeline: undefined, indices: true })));
+  } else {
+    // A stored map (js/map_sync.js) saves uploading the grid
+    const grid = options.mapId ? null : await measure('build payload', gridRows);
+    const result = await solveRemote(grid, start, end, algorithm, { ...options, timeline });
+    if (result.degraded) console.warn('Server busy: showing a near-shortest path without the exploration.');
+    await measure('decode response', () => {
+      visited = toIndices(result.visited);
+      path = toIndices(result.path);
+      if (result.frontier) frontier = flattenFrontier(result.frontier);
+    });
+    server = result.timeline || null;
+  }
+  const message = { type: 'paint', id, visited, path };
+  if (frontier) message.frontier = frontier;
+  if (timeline) message.timeline = { events: timeline.events, ...server };
+  self.postMessage(message, transferables(visited, path, ...(frontier ? Object.values(frontier) : [])));
+}
+
+const handlers = {
+  reset({ rows: r, cols: c, walls }) {
+    rows = r;
+    cols = c;
+    cells = walls || new Uint8Array(r * c);
+  },
+
+  patch({ r0, c0, width, data }) {
+    for (let i = 0; i * width < data.length; i++) {
+      cells.set(data.subarray(i * width, (i + 1) * width), (r0 + i) * cols + c0);
+    }
+  },
+
+  solve,
+
+  async record({ id, start, end, algorithm, options = {} }) {
+    const grid = options.mapId ? null : gridRows();
+    const buffer = await recordTrace(grid, start, end, algorithm, options);
+    self.postMessage({ type: 'trace', id, buffer }, [buffer]);
+  },
+
+  decode({ id, buffer }) {
+    const trace = decodeTrace(buffer);
+    const views = [trace.walls, trace.kinds, trace.cells, trace.g, trace.f, trace.extents,
+      trace.expansions, trace.expansionExtents, trace.path].filter(Boolean);
+    self.postMessage({ type: 'decoded', id, trace }, views.map((view) => view.buffer));
+  },
+};
+
+self.addEventListener('message', async (event) => {
+  const message = event.data;
+  try {
+    await handlers[message.type](message);
+  } catch (err) {
+    self.postMessage({ type: 'error', id: message.id, message: err.message });
+  }
+});
@@ -0,0 +1,345 @@
+// In-browser search engine: ports of the server algorithms over a flat,
+// row-major Uint8Array grid (0 = empty, 1 = wall). Each search returns the
+// same { visited, path } the server would for the same input, including the
+// tie-breaking order, so the visualization does not depend on where it ran.
+// Internally nodes are row-major cell indices (row * cols + col).
+
+// Neighbor directions: up, right, down, left (same order as the server)
+const DIRECTIONS = [[-1, 0], [0, 1], [1, 0], [0, -1]];
+const DIAGONALS = [[-1, 1], [1, 1], [1, -1], [-1, -1]];
+const STRAIGHT_COST = 100;
+const DIAGONAL_COST = 141;
+
+/**
+ * Minimal binary min-heap over arrays compared element by element,
+ * matching Python's tuple ordering in heapq.
+ */
+class TupleHeap {
+  constructor() {
+    this.items = [];
+  }
+
+  get size() {
+    return this.items.length;
+  }
+
+  static less(a, b) {
+    for (let i = 0; i < a.length; i++) {
+      if (a[i] !== b[i]) return a[i] < b[i];
+    }
+    return false;
+  }
+
+  push(item) {
+    const items = this.items;
+    items.push(item);
+    let i = items.length - 1;
+    while (i > 0) {
+      const p = (i - 1) >> 1;
+      if (!TupleHeap.less(items[i], items[p])) break;
+      [items[i], items[p]] = [items[p], items[i]];
+      i = p;
+    }
+  }
+
+  pop() {
+    const items = this.items;
+    const top = items[0];
+    const last = items.pop();
+    if (items.length > 0) {
+      items[0] = last;
+      let i = 0;
+      for (;;) {
+        const l = 2 * i + 1;
+        const r = l + 1;
+        let m = i;
+        if (l < items.length && TupleHeap.less(items[l], items[m])) m = l;
+        if (r < items.length && TupleHeap.less(items[r], items[m])) m = r;
+        if (m === i) break;
+        [items[i], items[m]] = [items[m], items[i]];
+        i = m;
+      }
+    }
+    return top;
+  }
+}
+
+function makeContext(cells, rows, cols, start, end) {
+  const s = start[0] * cols + start[1];
+  const e = end[0] * cols + end[1];
+  const inBounds = (r, c) => r >= 0 && r < rows && c >= 0 && c < cols;
+  const valid = inBounds(start[0], start[1]) && inBounds(end[0], end[1])
+    && cells[s] === 0 && cells[e] === 0;
+  return { cells, rows, cols, s, e, valid, inBounds };
+}
+
+function reconstruct(parent, s, e) {
+  const path = [];
+  let node = e;
+  while (node !== s) {
+    path.push(node);
+    node = parent[node];
+    if (node === -1) break;
+  }
+  path.push(s);
+  return path.reverse();
+}
+
+function bfsLike(ctx, trace, useStack) {
+  const { cells, rows, cols, s, e, inBounds } = ctx;
+  const visited = new Uint8Array(rows * cols);
+  const parent = new Int32Array(rows * cols).fill(-1);
+  const order = [];
+  const frontier = [s];
+  let head = 0;
+  visited[s] = 1;
+  let found = false;
+  while (useStack ? frontier.length > 0 : head < frontier.length) {
+    const cur = useStack ? frontier.pop() : frontier[head++];
+    const r = Math.floor(cur / cols);
+    const c = cur % cols;
+    if (trace) order.push(cur);
+    if (cur === e) {
+      found = true;
+      break;
+    }
+    for (const [dr, dc] of DIRECTIONS) {
+      const nr = r + dr;
+      const nc = c + dc;
+      const n = nr * cols + nc;
+      if (inBounds(nr, nc) && !visited[n] && cells[n] === 0) {
+        frontier.push(n);
+        visited[n] = 1;
+        parent[n] = cur;
+      }
+    }
+  }
+  return { visited: order, path: found ? reconstruct(parent, s, e) : [] };
+}
+
+function octileHeuristic(r1, c1, r2, c2) {
+  const dr = Math.abs(r1 - r2);
+  const dc = Math.abs(c1 - c2);
+  return STRAIGHT_COST * Math.abs(dr - dc) + DIAGONAL_COST * Math.min(dr, dc);
+}
+
+// Port of algorithms/canonical.py
+function legalMove(passable, r, c, dr, dc) {
+  if (!passable(r + dr, c + dc)) return false;
+  if (dr && dc) return passable(r + dr, c) && passable(r, c + dc);
+  return true;
+}
+
+function successorMoves(passable, r, c, parentIdx, cols, canonical) {
+  if (!canonical || parentIdx === -1) {
+    return DIRECTIONS.concat(DIAGONALS).filter(([dr, dc]) => legalMove(passable, r, c, dr, dc));
+  }
+  const dr = r - Math.floor(parentIdx / cols);
+  const dc = c - (parentIdx % cols);
+  const candidates = [];
+  if (dr && dc) {
+    candidates.push([dr, 0], [0, dc], [dr, dc]);
+  } else {
+    candidates.push([dr, dc]);
+    for (const side of [-1, 1]) {
+      const [sr, sc] = dc ? [side, 0] : [0, side];
+      if (!passable(r + sr - dr, c + sc - dc) && passable(r + sr, c + sc)) {
+        candidates.push([sr, sc], [sr + dr, sc + dc]);
+      }
+    }
+  }
+  return candidates.filter(([mr, mc]) => legalMove(passable, r, c, mr, mc));
+}
+
+/**
+ * Shared best-first loop for Dijkstra, A* and greedy best-first.
+ * mode: 'dijkstra' keys (g, cell); 'astar' keys (f, count, cell); 'gbfs' keys (h, count, cell)
+ */
+function bestFirst(ctx, trace, mode, diagonal = false, canonical = false) {
+  const { cells, rows, cols, s, e, inBounds } = ctx;
+  const er = Math.floor(e / cols);
+  const ec = e % cols;
+  const passable = (r, c) => inBounds(r, c) && cells[r * cols + c] === 0;
+  const heuristic = (r, c) => (diagonal
+    ? octileHeuristic(r, c, er, ec)
+    : Math.abs(r - er) + Math.abs(c - ec));
+
+  const n = rows * cols;
+  const g = new Float64Array(n).fill(Infinity);
+  const closed = new Uint8Array(n);
+  const parent = new Int32Array(n).fill(-1);
+  const order = [];
+  const heap = new TupleHeap();
+  let count = 0;
+
+  g[s] = 0;
+  if (mode === 'dijkstra') heap.push([0, s]);
+  else heap.push([heuristic(Math.floor(s / cols), s % cols), 0, s]);
+
+  while (heap.size > 0) {
+    const item = heap.pop();
+    const cur = item[item.length - 1];
+    if (closed[cur]) continue;
+    closed[cur] = 1;
+    const r = Math.floor(cur / cols);
+    const c = cur % cols;
+    if (trace) order.push(cur);
+    if (cur === e) break;
+
+    const moves = diagonal
+      ? successorMoves(passable, r, c, parent[cur], cols, canonical)
+      : DIRECTIONS;
+    for (const [dr, dc] of moves) {
+      const nr = r + dr;
+      const nc = c + dc;
+      const nb = nr * cols + nc;
+      if (!inBounds(nr, nc) || closed[nb] || cells[nb] !== 0) continue;
+
+      if (mode === 'gbfs') {
+        parent[nb] = cur;
+        count += 1;
+        heap.push([heuristic(nr, nc), count, nb]);
+        continue;
+      }
+      const step = diagonal ? (dr && dc ? DIAGONAL_COST : STRAIGHT_COST) : 1;
+      const tentative = (mode === 'dijkstra' ? item[0] : g[cur]) + step;
+      if (tentative < g[nb]) {
+        g[nb] = tentative;
+        parent[nb] = cur;
+        if (mode === 'dijkstra') {
+          heap.push([tentative, nb]);
+        } else {
+          count += 1;
+          heap.push([tentative + heuristic(nr, nc), count, nb]);
+        }
+      }
+    }
+  }
+
+  const found = parent[e] !== -1 || s === e;
+  return { visited: order, path: found ? reconstruct(parent, s, e) : [] };
+}
+
+function bidirectional(ctx, trace) {
+  const { cells, rows, cols, s, e, inBounds } = ctx;
+
+  const n = rows * cols;
+  const seen = [new Uint8Array(n), new Uint8Array(n)];
+  const parent = [new Int32Array(n).fill(-1), new Int32Array(n).fill(-1)];
+  const queues = [[s], [e]];
+  seen[0][s] = 1;
+  seen[1][e] = 1;
+  const order = [];
+  let meet = -1;
+
+  while (queues[0].length && queues[1].length && meet === -1) {
+    for (let side = 0; side < 2 && meet === -1; side++) {
+      const other = 1 - side;
+      const queue = queues[side];
+      const levelSize = queue.length;
+      let head = 0;
+      for (; head < levelSize && meet === -1; head++) {
+        const cur = queue[head];
+        const r = Math.floor(cur / cols);
+        const c = cur % cols;
+        if (trace) order.push(cur);
+        for (const [dr, dc] of DIRECTIONS) {
+          const nr = r + dr;
+          const nc = c + dc;
+          const nb = nr * cols + nc;
+          if (inBounds(nr, nc) && !seen[side][nb] && cells[nb] === 0) {
+            queue.push(nb);
+            seen[side][nb] = 1;
+            parent[side][nb] = cur;
+            if (seen[other][nb]) {
+              meet = nb;
+              break;
+            }
+          }
+        }
+      }
+      queues[side] = queue.slice(head);
+    }
+  }
+
+  if (meet === -1) return { visited: order, path: [] };
+  const path = reconstruct(parent[0], s, meet);
+  for (let node = parent[1][meet]; node !== -1; node = parent[1][node]) {
+    path.push(node);
+    if (node === e) break;
+  }
+  return { visited: order, path };
+}
+
+const ENGINES = {
+  bfs: (ctx, trace) => bfsLike(ctx, trace, false),
+  dfs: (ctx, trace) => bfsLike(ctx, trace, true),
+  dijkstra: (ctx, trace) => bestFirst(ctx, trace, 'dijkstra'),
+  astar: (ctx, trace) => bestFirst(ctx, trace, 'astar'),
+  gbfs: (ctx, trace) => bestFirst(ctx, trace, 'gbfs'),
+  bidirectional,
+  dijkstra_8: (ctx, trace) => bestFirst(ctx, trace, 'dijkstra', true),
+  canonical_dijkstra: (ctx, trace) => bestFirst(ctx, trace, 'dijkstra', true, true),
+  astar_8: (ctx, trace) => bestFirst(ctx, trace, 'astar', true),
+  canonical_astar: (ctx, trace) => bestFirst(ctx, trace, 'astar', true, true),
+};
+
+/** Algorithm keys the local engine can run. */
+export const LOCAL_ALGORITHMS = Object.keys(ENGINES);
+
+/**
+ * Copy a 2D grid into a flat Uint8Array, backed by a SharedArrayBuffer when the
+ * page is cross-origin isolated so it can later be shared with workers for free.
+ *
+ * @param {number[][]} grid 2D array (0 = empty, 1 = wall)
+ * @returns {Uint8Array}
+ */
+export function packGrid(grid) {
+  const rows = grid.length;
+  const cols = rows > 0 ? grid[0].length : 0;
+  const shared = typeof SharedArrayBuffer !== 'undefined' && globalThis.crossOriginIsolated;
+  const buffer = shared ? new SharedArrayBuffer(rows * cols) : new ArrayBuffer(rows * cols);
+  const cells = new Uint8Array(buffer);
+  for (let r = 0; r < rows; r++) {
+    cells.set(grid[r], r * cols);
+  }
+  return cells;
+}
+
+/**
+ * Run a search locally on a flat grid.
+ *
+ * @param {Uint8Array} cells Row-major grid (0 = empty, 1 = wall)
+ * @param {number} rows
+ * @param {number} cols
+ * @param {[number, number]} start
+ * @param {[number, number]} end
+ * @param {string} algorithm One of LOCAL_ALGORITHMS
+ * @param {{ trace?: 'none'|'full', indices?: boolean }} [options]
+ *   `indices` returns visited/path as Int32Arrays of row-major cell indices
+ *   instead of [row, col] pairs
+ * @returns {{ visited: Array<[number, number]>|Int32Array, path: Array<[number, number]>|Int32Array }}
+ */
+export function solveLocal(cells, rows, cols, start, end, algorithm,
+  { trace = 'full', indices = false } = {}) {
+  const engine = ENGINES[algorithm];
+  if (!engine) throw new Error(`Algorithm '${algorithm}' is not available locally.`);
+  const ctx = makeContext(cells, rows, cols, start, end);
+
+  let result;
+  if (algorithm === 'bidirectional' && ctx.s === ctx.e) {
+    // Answered before validating, like the server
+    if (!indices) return { visited: [[start[0], start[1]]], path: [[start[0], start[1]]] };
+    result = { visited: [ctx.s], path: [ctx.s] };
+  } else if (!ctx.valid) {
+    result = { visited: [], path: [] };
+  } else {
+    result = engine(ctx, trace !== 'none');
+  }
+
+  if (indices) {
+    return { visited: Int32Array.from(result.visited), path: Int32Array.from(result.path) };
+  }
+  const toCell = (idx) => [Math.floor(idx / cols), idx % cols];
+  return { visited: result.visited.map(toCell), path: result.path.map(toCell) };
+}
@@ -1,16 +1,34 @@
 import {
   initializeGrid,
-  getGridState,
+  getEndpoints,
+  loadGridState,
   clearGrid,
-  clearAnimations
+  clearAnimations,
+  fitGrid,
+  loadGeneratedMap,
+  setTool
 } from './grid.js';
-import { solve } from './api.js';
-import { animateSearch } from './animate.js';
+import { canSolveLocally, fetchTimeline, generateMap } from './api.js';
+import { ensureRemoteMap } from './map_sync.js';
+import { animateSearch, seekAnimation } from './animate.js';
+import { decodeTraceInWorker, recordTraceInWorker, solveInWorker } from './worker_client.js';
+import { PAGE_PID, Timeline, downloadTimeline, mergeTimelines, nowUs } from './timeline.js';
 
 // DOM elements
 const runBtn = document.getElementById('run-btn');
 const clearBtn = document.getElementById('clear-btn');
+const fitBtn = document.getElementById('fit-btn');
+const sizeSelect = document.getElementById('grid-size');
+const toolSelect = document.getElementById('tool');
+const generatorSelect = document.getElementById('generator');
+const generateBtn = document.getElementById('generate-btn');
 const algoSelect = document.getElementById('algorithm');
+const saveTraceBtn = document.getElementById('save-trace-btn');
+const loadTraceBtn = document.getElementById('load-trace-btn');
+const traceFileInput = document.getElementById('trace-file');
+const seekSlider = document.getElementById('seek');
+const timelineToggle = document.getElementById('timeline');
+const frontierToggle = document.getElementById('frontier');
 
 // Initial grid setup
 const DEFAULT_ROWS = 60;
@@ -21,12 +39,41 @@ initializeGrid(DEFAULT_ROWS, DEFAULT_COLS);
 function setControlsDisabled(disabled) {
   runBtn.disabled = disabled;
   clearBtn.disabled = disabled;
+  sizeSelect.disabled = disabled;
+  generateBtn.disabled = disabled;
   algoSelect.disabled = disabled;
+  saveTraceBtn.disabled = disabled;
+  loadTraceBtn.disabled = disabled;
+  seekSlider.disabled = !disabled;
+}
+
+// Keep the seek slider in step with the running animation
+function trackProgress(step, total) {
+  seekSlider.max = total;
+  seekSlider.value = step;
+}
+
+seekSlider.addEventListener('input', () => {
+  seekAnimation(Number(seekSlider.value));
+});
+
+// Download one trace of the run: page phases, worker spans and, for server
+// solves, the server's own timeline placed inside the worker's fetch
+async function saveTimeline(timeline, solved, algorithm) {
+  const events = [...timeline.events, ...solved.events];
+  let server = null;
+  if (solved.id) {
+    server = await fetchTimeline(solved.id).catch((err) => {
+      console.warn(`Timeline saved without the server side: ${err.message}`);
+      return null;
+    });
+  }
+  downloadTimeline(mergeTimelines(events, server, solved.fetch), `timeline-${algorithm}.json`);
 }
 
 // Run button handler
 runBtn.addEventListener('click', async () => {
-  const { grid, start, end } = getGridState();
+  const { rows, cols, start, end } = getEndpoints();
   const algorithm = algoSelect.value;
 
   if (!start || !end) {
@@ -39,8 +86,17 @@ runBtn.addEventListener('click', async () => {
   setControlsDisabled(true);
 
   try {
-    const { visited, path } = await solve(grid, start, end, algorithm);
-    await animateSearch(visited, path);
+    // The worker holds the grid; only the paint commands come back
+    const timeline = timelineToggle.checked ? new Timeline(PAGE_PID) : null;
+    const requested = nowUs();
+    // Frontier snapshots only come from the server
+    const options = frontierToggle.checked ? { trace: 'frontier' } : {};
+    if (!canSolveLocally(rows, cols, algorithm, options)) Object.assign(options, await remoteOptions());
+    if (timeline) options.timeline = true;
+    const { visited, path, frontier, timeline: solved } = await solveInWorker(start, end, algorithm, options);
+    if (timeline) timeline.span('solve (worker round trip)', requested, nowUs(), { algorithm });
+    await animateSearch(visited, path, { cols, frontier, onProgress: trackProgress, timeline });
+    if (timeline) await saveTimeline(timeline, solved, algorithm);
   } catch (err) {
     console.error(err);
     alert(`Error running algorithm: ${err.message}`);
@@ -52,4 +108,83 @@ runBtn.addEventListener('click', async () => {
 // Clear button handler: fully reset (walls, start, end, and animations)
 clearBtn.addEventListener('click', () => {
   clearGrid(false);
-});
\ No newline at end of file
+});
+
+// Grid size: start over with an empty square grid
+sizeSelect.addEventListener('change', () => {
+  const size = Number(sizeSelect.value);
+  initializeGrid(size, size);
+});
+
+fitBtn.addEventListener('click', fitGrid);
+
+// Generate: replace the grid with a new seeded map of the selected size
+generateBtn.addEventListener('click', async () => {
+  const size = Number(sizeSelect.value);
+  setControlsDisabled(true);
+  try {
+    const seed = Math.floor(Math.random() * 2 ** 31);
+    loadGeneratedMap(await generateMap(generatorSelect.value, size, size, seed));
+  } catch (err) {
+    console.error(err);
+    alert(`Error generating map: ${err.message}`);
+  } finally {
+    setControlsDisabled(false);
+  }
+});
+
+toolSelect.addEventListener('change', () => setTool(toolSelect.value));
+
+// Server runs name the stored copy of the map instead of uploading the grid;
+// without a reachable map store the worker falls back to sending it
+async function remoteOptions() {
+  const mapId = await ensureRemoteMap();
+  return mapId ? { mapId } : {};
+}
+
+// Save trace: record the current search on the server and download it
+saveTraceBtn.addEventListener('click', async () => {
+  const { start, end } = getEndpoints();
+  const algorithm = algoSelect.value;
+  if (!start || !end) {
+    alert('Please set both a start and an end point before recording.');
+    return;
+  }
+
+  try {
+    const buffer = await recordTraceInWorker(start, end, algorithm, await remoteOptions());
+    const link = document.createElement('a');
+    link.href = URL.createObjectURL(new Blob([buffer], { type: 'application/octet-stream' }));
+    link.download = `${algorithm}.pftr`;
+    link.click();
+    URL.revokeObjectURL(link.href);
+  } catch (err) {
+    console.error(err);
+    alert(`Error recording trace: ${err.message}`);
+  }
+});
+
+// Load trace: rebuild the recorded grid and replay the search without rerunning it
+loadTraceBtn.addEventListener('click', () => traceFileInput.click());
+
+traceFileInput.addEventListener('change', async () => {
+  const file = traceFileInput.files[0];
+  traceFileInput.value = '';
+  if (!file) return;
+
+  setControlsDisabled(true);
+  try {
+    const trace = await decodeTraceInWorker(await file.arrayBuffer());
+    loadGridState(trace.rows, trace.cols, trace.walls, trace.start, trace.end);
+    await animateSearch(trace.expansions, trace.path, {
+      cols: trace.cols,
+      extents: trace.expansionExtents,
+      onProgress: trackProgress,
+    });
+  } catch (err) {
+    console.error(err);
+    alert(`Error loading trace: ${err.message}`);
+  } finally {
+    setControlsDisabled(false);
+  }
+});
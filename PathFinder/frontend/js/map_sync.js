@@ -0,0 +1,107 @@
+// Keeps a server-side copy of the GridModel (see /api/maps) so server solves
+// can name the map instead of uploading it. The map is uploaded the first time
+// the server needs it; after that each edit stroke is sent as a run-length
+// encoded delta. All requests go through one queue so deltas arrive in order.
+// If the server loses the map or rejects a delta, the next use uploads afresh.
+
+import { createMap, patchMap } from './api.js';
+
+let model = null;
+let generation = 0; // bumped per model so queued work for an old grid is dropped
+let mapId = null;
+let version = 0;
+let queue = Promise.resolve();
+
+/**
+ * Runs covering every wall of the grid (for a first upload onto an empty map).
+ * @param {Uint8Array} cells Row-major grid
+ * @returns {number[]}
+ */
+export function encodeWalls(cells) {
+  const runs = [];
+  let i = 0;
+  while (i < cells.length) {
+    if (cells[i] === 1) {
+      const start = i;
+      while (i < cells.length && cells[i] === 1) i++;
+      runs.push(start, i - start, 1);
+    } else {
+      i++;
+    }
+  }
+  return runs;
+}
+
+/**
+ * Row-major wall flags from runs applied to an empty grid (the inverse of encodeWalls).
+ * @param {number[]} runs Flat [start, length, value, ...]
+ * @param {number} size Number of cells
+ * @returns {Uint8Array}
+ */
+export function decodeRuns(runs, size) {
+  const cells = new Uint8Array(size);
+  for (let k = 0; k < runs.length; k += 3) {
+    cells.fill(runs[k + 2], runs[k], runs[k] + runs[k + 1]);
+  }
+  return cells;
+}
+
+// Run `task(current)` after everything queued before it, unless the model has
+// been replaced by then; `current()` tells the task whether it still is after an await
+function enqueue(task) {
+  const gen = generation;
+  const current = () => gen === generation;
+  queue = queue.then(() => (current() ? task(current) : undefined)).catch((err) => {
+    console.warn('Map sync failed; the map will be uploaded again when needed.', err);
+    if (current()) mapId = null;
+  });
+  return queue;
+}
+
+/** Start tracking a new grid model; any previous server map is abandoned. */
+export function attachMapSync(next) {
+  model = next;
+  generation++;
+  mapId = null;
+  version = 0;
+}
+
+/**
+ * Use a map the server already holds (e.g. a generated one) for the current
+ * model, instead of uploading it again.
+ * @param {string} id
+ * @param {number} mapVersion
+ */
+export function adoptRemoteMap(id, mapVersion) {
+  mapId = id;
+  version = mapVersion;
+}
+
+/**
+ * Send the cells changed by one edit stroke, if the map is on the server yet.
+ * @param {number[]} runs Changed cells' values, from GridModel.endStroke()
+ */
+export function sendStroke(runs) {
+  if (runs.length === 0) return;
+  enqueue(async (current) => {
+    // Not uploaded yet: the upload will include this stroke
+    if (!mapId) return;
+    const result = await patchMap(mapId, version, runs);
+    if (current()) version = result.version;
+  });
+}
+
+/**
+ * Make sure the server has the current map, uploading it if needed.
+ * @returns {Promise<string|null>} The map id, or null if the server is unreachable
+ */
+export async function ensureRemoteMap() {
+  await enqueue(async (current) => {
+    if (mapId) return;
+    const created = await createMap(model.rows, model.cols, encodeWalls(model.cells));
+    if (!current()) return;
+    mapId = created.map_id;
+    version = created.version;
+  });
+  return mapId;
+}
@@ -0,0 +1,49 @@
+// Wall patterns for the stamp tool, centered on the clicked cell.
+// '#' is a wall; any other character leaves the cell as it is.
+
+export const STAMPS = {
+  room: [
+    '#########',
+    '#.......#',
+    '#.......#',
+    '#.......#',
+    '#........',
+    '#.......#',
+    '#.......#',
+    '#.......#',
+    '#########',
+  ],
+  cross: [
+    '...#...',
+    '...#...',
+    '...#...',
+    '#######',
+    '...#...',
+    '...#...',
+    '...#...',
+  ],
+  pillars: [
+    '##...##...##',
+    '##...##...##',
+    '............',
+    '............',
+    '##...##...##',
+    '##...##...##',
+    '............',
+    '............',
+    '##...##...##',
+    '##...##...##',
+  ],
+  spiral: [
+    '###########',
+    '#.........#',
+    '#.#######.#',
+    '#.#.....#.#',
+    '#.#.###.#.#',
+    '#.#.#.#.#.#',
+    '#.#.#...#.#',
+    '#.#.#####.#',
+    '#.#.......#',
+    '#.#########',
+  ],
+};
@@ -0,0 +1,78 @@
+// Request timelines in Chrome trace-event format, for chrome://tracing or
+// Perfetto. The page and the grid worker record their own spans; a server solve
+// sent with `X-Timeline: 1` records one too (backend/utils/timeline.py), and
+// mergeTimelines() puts all three processes on one time axis.
+//
+// Page and worker share a clock (performance.timeOrigin + now()). The server's
+// clock is unrelated, so its spans are placed in the middle of the fetch that
+// carried them: the gap on either side is the network and queueing time.
+
+export const PAGE_PID = 1;
+export const WORKER_PID = 2;
+const PROCESS_NAMES = { [PAGE_PID]: 'page', [WORKER_PID]: 'grid worker', 3: 'server' };
+
+/** Microseconds since the epoch, comparable between the page and its workers. */
+export function nowUs() {
+  return Math.round((performance.timeOrigin + performance.now()) * 1000);
+}
+
+export class Timeline {
+  /** @param {number} pid PAGE_PID or WORKER_PID */
+  constructor(pid) {
+    this.pid = pid;
+    this.events = [];
+  }
+
+  /** Record a finished span and return its event. */
+  span(name, started, ended = nowUs(), args = undefined) {
+    const event = { name, cat: 'client', ph: 'X', ts: started, dur: ended - started, pid: this.pid, tid: 1 };
+    if (args) event.args = args;
+    this.events.push(event);
+    return event;
+  }
+
+  /** Run `fn` (sync or async) inside a span named `name`. */
+  async measure(name, fn, args = undefined) {
+    const started = nowUs();
+    try {
+      return await fn();
+    } finally {
+      this.span(name, started, nowUs(), args);
+    }
+  }
+}
+
+/**
+ * One trace from the page's and worker's events plus, optionally, a server
+ * timeline (GET /api/timelines/<id>) recorded during the `fetch` event.
+ *
+ * @param {object[]} events Page and worker trace events
+ * @param {{ traceEvents: object[] }} [server]
+ * @param {object} [fetch] The client span of the request the server timeline belongs to
+ * @returns {{ traceEvents: object[], displayTimeUnit: string }}
+ */
+export function mergeTimelines(events, server = null, fetch = null) {
+  const merged = [...events];
+  if (server && fetch) {
+    const spans = server.traceEvents.filter((event) => event.ph === 'X');
+    const serverDur = Math.max(0, ...spans.map((event) => event.ts + event.dur));
+    const offset = fetch.ts + Math.max(0, (fetch.dur - serverDur) / 2);
+    for (const event of server.traceEvents) {
+      merged.push(event.ph === 'X' ? { ...event, ts: event.ts + offset } : event);
+    }
+  }
+  const pids = new Set(events.map((event) => event.pid));
+  const meta = [...pids].map((pid) => ({
+    name: 'process_name', ph: 'M', pid, args: { name: PROCESS_NAMES[pid] },
+  }));
+  return { traceEvents: [...meta, ...merged], displayTimeUnit: 'ms' };
+}
+
+/** Save a trace from mergeTimelines() as a JSON download. */
+export function downloadTimeline(trace, filename) {
+  const link = document.createElement('a');
+  link.href = URL.createObjectURL(new Blob([JSON.stringify(trace)], { type: 'application/json' }));
+  link.download = filename;
+  link.click();
+  URL.revokeObjectURL(link.href);
+}
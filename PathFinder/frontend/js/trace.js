@@ -0,0 +1,145 @@
+// Decodes binary exploration trace files recorded by the server (`/api/trace`).
+// Format reference: backend/utils/trace_file.py; keep the two in sync.
+
+const MAGIC = 'PFTR';
+const VERSION = 1;
+const FLAG_HAS_COSTS = 1;
+const FLAG_HAS_EXTENTS = 2;
+const FLAG_HAS_MISSING_COSTS = 4;
+const HEADER_SIZE = 4 + 1 + 1 + 4 * 7 + 4 * 6;
+
+export const EXPAND = 0;
+export const PUSH = 1;
+
+// Decode `count` zigzag varint deltas into a running sum. Arithmetic instead of
+// bitwise ops so values beyond 32 bits (large scaled costs) stay exact.
+function readDeltas(bytes, count, Out) {
+  const out = new Out(count);
+  let pos = 0;
+  let prev = 0;
+  for (let i = 0; i < count; i++) {
+    let raw = 0;
+    let mul = 1;
+    let byte;
+    do {
+      byte = bytes[pos++];
+      raw += (byte & 0x7f) * mul;
+      mul *= 128;
+    } while (byte >= 0x80);
+    prev += raw % 2 === 0 ? raw / 2 : -(raw + 1) / 2;
+    out[i] = prev;
+  }
+  return out;
+}
+
+function readBits(bytes, count) {
+  const out = new Uint8Array(count);
+  for (let i = 0; i < count; i++) {
+    out[i] = (bytes[i >> 3] >> (i & 7)) & 1;
+  }
+  return out;
+}
+
+/**
+ * Parse a trace file.
+ *
+ * @param {ArrayBuffer} buffer Raw trace file contents
+ * @returns {{ rows: number, cols: number, walls: Uint8Array, start: [number, number],
+ *   end: [number, number], kinds: Uint8Array, cells: Int32Array, g: Float64Array|null,
+ *   f: Float64Array|null, extents: Int32Array|null, expansions: Int32Array,
+ *   expansionExtents: Int32Array|null, path: Int32Array }}
+ *   Cells are row-major indices (row * cols + col). Costs an event did not
+ *   report are NaN in g and f. Traces of block searches carry extents: the
+ *   height and width of each event's block, interleaved.
+ */
+export function decodeTrace(buffer) {
+  const view = new DataView(buffer);
+  const magic = String.fromCharCode(...new Uint8Array(buffer, 0, 4));
+  if (magic !== MAGIC) throw new Error('Not a PathFinder trace file.');
+  const version = view.getUint8(4);
+  if (version !== VERSION) throw new Error(`Unsupported trace version ${version}.`);
+
+  const flags = view.getUint8(5);
+  const u32 = (offset) => view.getUint32(offset, true);
+  const rows = u32(6);
+  const cols = u32(10);
+  const start = u32(14);
+  const end = u32(18);
+  const nEvents = u32(22);
+  const nPath = u32(26);
+  const scale = u32(30);
+
+  const columns = [];
+  let pos = HEADER_SIZE;
+  for (let i = 0; i < 6; i++) {
+    const length = u32(34 + 4 * i);
+    columns.push(new Uint8Array(buffer, pos, length));
+    pos += length;
+  }
+  const [wallBytes, kindBytes, cellBytes, gBytes, fBytes, pathBytes] = columns;
+
+  const kinds = readBits(kindBytes, nEvents);
+  const cells = readDeltas(cellBytes, nEvents, Int32Array);
+  let g = null;
+  let f = null;
+  if (flags & FLAG_HAS_COSTS) {
+    g = readDeltas(gBytes, nEvents, Float64Array);
+    f = readDeltas(fBytes, nEvents, Float64Array);
+    if (scale !== 1) {
+      for (let i = 0; i < nEvents; i++) {
+        g[i] /= scale;
+        f[i] /= scale;
+      }
+    }
+  }
+
+  // Optional columns after the path, each preceded by its byte length
+  const trailing = () => {
+    const length = u32(pos);
+    const bytes = new Uint8Array(buffer, pos + 4, length);
+    pos += 4 + length;
+    return bytes;
+  };
+
+  let extents = null;
+  if (flags & FLAG_HAS_EXTENTS) {
+    extents = readDeltas(trailing(), 2 * nEvents, Int32Array);
+  }
+  if (flags & FLAG_HAS_MISSING_COSTS) {
+    const present = readBits(trailing(), 2 * nEvents);
+    for (let i = 0; i < nEvents; i++) {
+      if (!present[i]) g[i] = NaN;
+      if (!present[nEvents + i]) f[i] = NaN;
+    }
+  }
+
+  // Cell indices (and extents) of the expansion events, i.e. what animateSearch() replays
+  let nExpansions = 0;
+  for (let i = 0; i < nEvents; i++) nExpansions += kinds[i] === EXPAND;
+  const expansions = new Int32Array(nExpansions);
+  const expansionExtents = extents && new Int32Array(2 * nExpansions);
+  for (let i = 0, j = 0; i < nEvents; i++) {
+    if (kinds[i] !== EXPAND) continue;
+    if (extents) {
+      expansionExtents[2 * j] = extents[2 * i];
+      expansionExtents[2 * j + 1] = extents[2 * i + 1];
+    }
+    expansions[j++] = cells[i];
+  }
+
+  return {
+    rows,
+    cols,
+    walls: readBits(wallBytes, rows * cols),
+    start: [Math.floor(start / cols), start % cols],
+    end: [Math.floor(end / cols), end % cols],
+    kinds,
+    cells,
+    g,
+    f,
+    extents,
+    expansions,
+    expansionExtents,
+    path: readDeltas(pathBytes, nPath, Int32Array),
+  };
+}
@@ -0,0 +1,96 @@
+// Main-thread side of js/grid_worker.js: keeps the worker's grid in step with
+// the GridModel and turns its replies into promises. Wall edits are not sent as
+// they happen; the model's dirty region is synced right before each request (or
+// not at all when the model's cells live in shared memory).
+
+const worker = new Worker(new URL('./grid_worker.js', import.meta.url), { type: 'module' });
+
+let nextId = 1;
+const pending = new Map(); // id -> { resolve, reject }
+
+let model = null;
+
+worker.addEventListener('message', (event) => {
+  const { type, id, ...data } = event.data;
+  const request = pending.get(id);
+  if (!request) return;
+  pending.delete(id);
+  if (type === 'error') {
+    request.reject(new Error(data.message));
+  } else {
+    request.resolve(data);
+  }
+});
+
+function isShared(cells) {
+  return typeof SharedArrayBuffer !== 'undefined' && cells.buffer instanceof SharedArrayBuffer;
+}
+
+// Copy the rectangle of walls changed since the last sync into the worker
+function syncModel() {
+  const dirty = model.takeSyncDirty();
+  if (!dirty || isShared(model.cells)) return;
+  const [r0, c0, r1, c1] = dirty;
+  const width = c1 - c0 + 1;
+  const data = new Uint8Array((r1 - r0 + 1) * width);
+  for (let r = r0; r <= r1; r++) {
+    const from = r * model.cols + c0;
+    data.set(model.cells.subarray(from, from + width), (r - r0) * width);
+  }
+  worker.postMessage({ type: 'patch', r0, c0, width, data }, [data.buffer]);
+}
+
+function request(message, transfer = []) {
+  syncModel();
+  const id = nextId++;
+  return new Promise((resolve, reject) => {
+    pending.set(id, { resolve, reject });
+    worker.postMessage({ ...message, id }, transfer);
+  });
+}
+
+/**
+ * Point the worker at a new grid model. Shared cells are handed over as-is;
+ * otherwise the worker gets a copy and later patches.
+ * @param {import('./grid_model.js').GridModel} next
+ */
+export function attachWorkerModel(next) {
+  model = next;
+  model.takeSyncDirty();
+  const walls = isShared(model.cells) ? model.cells : model.cells.slice();
+  worker.postMessage({ type: 'reset', rows: model.rows, cols: model.cols, walls },
+    isShared(walls) ? [] : [walls.buffer]);
+}
+
+/**
+ * Solve the worker's grid. Same options as solve() in api.js, except that
+ * `timeline: true` asks for the worker's spans and the server's timeline id.
+ * @returns {Promise<{ visited: Int32Array|Array<number[]>, path: Int32Array|Array<number[]>,
+ *   frontier?: { at: Int32Array, offsets: Int32Array, cells: Int32Array },
+ *   timeline?: { events: object[], id?: string, fetch?: object } }>}
+ *   Row-major cell indices (or [row, col, height, width] blocks), ready for
+ *   animateSearch(); `frontier` only with `trace: 'frontier'`
+ */
+export function solveInWorker(start, end, algorithm, options = {}) {
+  return request({ type: 'solve', start, end, algorithm, options });
+}
+
+/**
+ * Record the search on the server as a binary trace file.
+ * @param {{ mapId?: string }} [options] Server copy of the grid to use
+ * @returns {Promise<ArrayBuffer>}
+ */
+export async function recordTraceInWorker(start, end, algorithm, options = {}) {
+  const { buffer } = await request({ type: 'record', start, end, algorithm, options });
+  return buffer;
+}
+
+/**
+ * Decode a trace file in the worker.
+ * @param {ArrayBuffer} buffer Trace file contents (transferred)
+ * @returns {Promise<object>} Result of decodeTrace() in js/trace.js
+ */
+export async function decodeTraceInWorker(buffer) {
+  const { trace } = await request({ type: 'decode', buffer }, [buffer]);
+  return trace;
+}